@@ -0,0 +1,118 @@
+#include "generate.hpp"
+
+#include <fstream>
+#include <map>
+#include <mutex>
+
+using namespace pajlada::Settings;
+
+namespace {
+
+void
+appendChannel(std::string &out, std::size_t index, bool first)
+{
+    auto name = "channel" + std::to_string(index);
+
+    if (!first) {
+        out += ",\n";
+    }
+
+    out += "        \"" + name + "\": {\n";
+    out += "            \"name\": \"" + name + "\",\n";
+    out += "            \"highlight\": " +
+           std::string(index % 2 == 0 ? "true" : "false") + ",\n";
+    out += "            \"volume\": " + std::to_string(index % 101) + ",\n";
+    out += "            \"scale\": " + std::to_string(index % 7) + ".5,\n";
+    out += "            \"filters\": [\"" + name + "-a\", \"" + name +
+           "-b\", \"" + name + "-c\"]\n";
+    out += "        }";
+}
+
+}  // namespace
+
+std::string
+GenerateDocument(std::size_t targetBytes)
+{
+    std::string out;
+    out.reserve(targetBytes + 512);
+
+    out += "{\n";
+    out += "    \"appearance\": {\n";
+    out += "        \"fontSize\": 12,\n";
+    out += "        \"theme\": \"dark\",\n";
+    out += "        \"compact\": false\n";
+    out += "    },\n";
+    out += "    \"channels\": {\n";
+
+    static constexpr auto closing = "\n    }\n}\n";
+    const auto closingSize = std::char_traits<char>::length(closing);
+
+    for (std::size_t i = 0; i == 0 || out.size() + closingSize < targetBytes;
+         ++i) {
+        appendChannel(out, i, i == 0);
+    }
+
+    out += closing;
+
+    return out;
+}
+
+std::filesystem::path
+GenerateDocumentFile(std::size_t targetBytes)
+{
+    static std::mutex mutex;
+    static std::map<std::size_t, std::filesystem::path> generated;
+
+    std::lock_guard lock(mutex);
+
+    auto it = generated.find(targetBytes);
+    if (it != generated.end()) {
+        return it->second;
+    }
+
+    auto path = BenchmarkDirectory() /
+                ("generated-" + std::to_string(targetBytes) + ".json");
+
+    std::ofstream fh(path, std::ios::binary | std::ios::out | std::ios::trunc);
+    auto contents = GenerateDocument(targetBytes);
+    fh.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+
+    generated.emplace(targetBytes, path);
+
+    return path;
+}
+
+std::vector<std::string>
+GeneratePaths(std::size_t count, const std::string &prefix)
+{
+    std::vector<std::string> paths;
+    paths.reserve(count);
+
+    for (std::size_t i = 0; i < count; ++i) {
+        paths.push_back("/" + prefix + "/" + std::to_string(i) + "/value");
+    }
+
+    return paths;
+}
+
+std::shared_ptr<SettingManager>
+MakeManager()
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SettingManager::SaveMethod::SaveManually;
+    sm->setBackupEnabled(false);
+
+    return sm;
+}
+
+std::filesystem::path
+BenchmarkDirectory()
+{
+    auto dir =
+        std::filesystem::temp_directory_path() / "pajlada-settings-benchmark";
+
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+
+    return dir;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <pajlada/settings/settingmanager.hpp>
+#include <string>
+#include <vector>
+
+/// Returns a JSON document of roughly `targetBytes` bytes when pretty-printed
+///
+/// The document looks like a chat client's settings file: a handful of
+/// top-level scalars, plus a "channels" object with one object per channel
+/// containing a mix of scalars, strings & a small array.
+std::string GenerateDocument(std::size_t targetBytes);
+
+/// Writes a document generated by GenerateDocument to a file in the benchmark
+/// directory, and returns the path to it.
+/// The file is only generated once per size & process.
+std::filesystem::path GenerateDocumentFile(std::size_t targetBytes);
+
+/// Returns `count` unique setting paths of the form /<prefix>/<i>/value
+std::vector<std::string> GeneratePaths(std::size_t count,
+                                       const std::string &prefix = "bench");
+
+/// Returns a new SettingManager that never saves on its own
+std::shared_ptr<pajlada::Settings::SettingManager> MakeManager();
+
+/// The directory benchmark files are written to
+std::filesystem::path BenchmarkDirectory();
@@ -0,0 +1,141 @@
+#include <benchmark/benchmark.h>
+
+#include <pajlada/settings.hpp>
+#include <pajlada/settings/atomicsetting.hpp>
+#include <string>
+#include <vector>
+
+#include "generate.hpp"
+
+using namespace pajlada::Settings;
+
+// Reading a setting whose cached value is up to date
+static void
+BM_GetValueHot(benchmark::State &state)
+{
+    auto sm = MakeManager();
+    Setting<int> a("/bench/getvalue/hot", sm);
+    a = 5;
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(a.getValue());
+    }
+}
+BENCHMARK(BM_GetValueHot);
+
+static void
+BM_GetValueAtomic(benchmark::State &state)
+{
+    auto sm = MakeManager();
+    AtomicSetting<bool> a("/bench/getvalue/atomic", sm);
+    a = true;
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(a.getValue());
+    }
+}
+BENCHMARK(BM_GetValueAtomic);
+
+static void
+BM_GetValueHotString(benchmark::State &state)
+{
+    auto sm = MakeManager();
+    Setting<std::string> a("/bench/getvalue/hot-string", sm);
+    a = std::string(64, 'x');
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(a.getValue());
+    }
+}
+BENCHMARK(BM_GetValueHotString);
+
+// Reading a setting after another handle has changed it, meaning the value
+// must be unmarshalled from the document again.
+// This includes the cost of the invalidating set, compare with BM_SetValue.
+static void
+BM_GetValueAfterInvalidation(benchmark::State &state)
+{
+    auto sm = MakeManager();
+    Setting<int> a("/bench/getvalue/invalidated", sm);
+    Setting<int> writer("/bench/getvalue/invalidated", sm);
+
+    int i = 0;
+    for (auto _ : state) {
+        writer = ++i;
+        benchmark::DoNotOptimize(a.getValue());
+    }
+}
+BENCHMARK(BM_GetValueAfterInvalidation);
+
+// Same as BM_GetValueAfterInvalidation, with both handles using FlatStorage
+static void
+BM_GetValueAfterInvalidationFlat(benchmark::State &state)
+{
+    auto sm = MakeManager();
+    Setting<int> a("/bench/getvalue/invalidated-flat",
+                   SettingOption::FlatStorage, sm);
+    Setting<int> writer("/bench/getvalue/invalidated-flat",
+                        SettingOption::FlatStorage, sm);
+
+    int i = 0;
+    for (auto _ : state) {
+        writer = ++i;
+        benchmark::DoNotOptimize(a.getValue());
+    }
+}
+BENCHMARK(BM_GetValueAfterInvalidationFlat);
+
+// Same as BM_GetValueAfterInvalidation, for a vector of `range(0)` strings
+static void
+BM_GetValueAfterInvalidationVector(benchmark::State &state)
+{
+    auto sm = MakeManager();
+    Setting<std::vector<std::string>> a("/bench/getvalue/vector", sm);
+
+    std::vector<std::string> values(static_cast<std::size_t>(state.range(0)),
+                                    "highlight phrase");
+
+    for (auto _ : state) {
+        sm->set(a.getPath(),
+                pajlada::Serialize<std::vector<std::string>>::get(
+                    values, sm->document.GetAllocator()));
+        benchmark::DoNotOptimize(a.getValue());
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_GetValueAfterInvalidationVector)->Range(8, 8 << 10);
+
+// Reading a deeply nested value straight from the document
+static void
+BM_ManagerGet(benchmark::State &state)
+{
+    auto sm = MakeManager();
+    auto path = GenerateDocumentFile(static_cast<std::size_t>(state.range(0)));
+    sm->loadFrom(path);
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(sm->get("/channels/channel0/volume"));
+    }
+}
+BENCHMARK(BM_ManagerGet)->Arg(1 << 10)->Arg(1 << 20);
+
+// Reading a value in the last channel of a large document, with the member
+// index disabled (0) & enabled
+static void
+BM_ManagerGetLastMember(benchmark::State &state)
+{
+    auto sm = MakeManager();
+    sm->loadFrom(GenerateDocumentFile(1 << 20));
+    sm->setMemberIndexThreshold(static_cast<std::size_t>(state.range(0)));
+
+    const auto &channels = sm->document["channels"];
+    auto path = "/channels/" +
+                std::string((channels.MemberEnd() - 1)->name.GetString()) +
+                "/volume";
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(sm->get(path));
+    }
+}
+BENCHMARK(BM_ManagerGetLastMember)->Arg(0)->Arg(64);
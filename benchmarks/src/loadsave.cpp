@@ -0,0 +1,76 @@
+#include <benchmark/benchmark.h>
+
+#include <filesystem>
+#include <pajlada/settings.hpp>
+
+#include "generate.hpp"
+
+using namespace pajlada::Settings;
+
+namespace {
+
+constexpr std::size_t KB = 1 << 10;
+constexpr std::size_t MB = 1 << 20;
+
+}  // namespace
+
+// Loading a generated document of roughly `range(0)` bytes
+static void
+BM_Load(benchmark::State &state)
+{
+    auto path = GenerateDocumentFile(static_cast<std::size_t>(state.range(0)));
+    auto fileSize = std::filesystem::file_size(path);
+
+    auto sm = MakeManager();
+
+    // A few registered settings so the notify phase has something to do
+    Setting<int> fontSize("/appearance/fontSize", sm);
+    Setting<int> volume("/channels/channel0/volume", sm);
+    Setting<bool> highlight("/channels/channel1/highlight", sm);
+
+    for (auto _ : state) {
+        if (sm->loadFrom(path) != SettingManager::LoadError::NoError) {
+            state.SkipWithError("Failed to load generated document");
+            break;
+        }
+    }
+
+    state.SetBytesProcessed(state.iterations() *
+                            static_cast<int64_t>(fileSize));
+}
+BENCHMARK(BM_Load)
+    ->Arg(KB)
+    ->Arg(MB)
+    ->Arg(50 * MB)
+    ->Unit(benchmark::kMillisecond);
+
+// Saving a generated document of roughly `range(0)` bytes
+// range(1) toggles backups
+static void
+BM_Save(benchmark::State &state)
+{
+    auto path = GenerateDocumentFile(static_cast<std::size_t>(state.range(0)));
+    auto fileSize = std::filesystem::file_size(path);
+
+    auto sm = MakeManager();
+    sm->setBackupEnabled(state.range(1) != 0);
+    if (sm->loadFrom(path) != SettingManager::LoadError::NoError) {
+        state.SkipWithError("Failed to load generated document");
+        return;
+    }
+
+    auto savePath = BenchmarkDirectory() / "save.json";
+
+    for (auto _ : state) {
+        if (sm->saveAs(savePath) != SettingManager::SaveResult::Success) {
+            state.SkipWithError("Failed to save document");
+            break;
+        }
+    }
+
+    state.SetBytesProcessed(state.iterations() *
+                            static_cast<int64_t>(fileSize));
+}
+BENCHMARK(BM_Save)
+    ->ArgsProduct({{KB, MB, 50 * MB}, {0, 1}})
+    ->Unit(benchmark::kMillisecond);
@@ -0,0 +1,114 @@
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <pajlada/settings.hpp>
+#include <string>
+#include <vector>
+
+#include "generate.hpp"
+
+using namespace pajlada::Settings;
+
+namespace {
+
+/// Registers `count` settings in the given manager
+std::vector<std::unique_ptr<Setting<int>>>
+fillRegistry(const std::shared_ptr<SettingManager> &sm, std::size_t count,
+             const std::string &prefix = "registry")
+{
+    std::vector<std::unique_ptr<Setting<int>>> settings;
+    settings.reserve(count);
+
+    for (const auto &path : GeneratePaths(count, prefix)) {
+        settings.push_back(std::make_unique<Setting<int>>(path, sm));
+    }
+
+    return settings;
+}
+
+}  // namespace
+
+// Registering a new path in a registry of `range(0)` settings
+static void
+BM_GetSettingNew(benchmark::State &state)
+{
+    auto sm = MakeManager();
+    auto existing = fillRegistry(sm, static_cast<std::size_t>(state.range(0)));
+    auto paths = GeneratePaths(1 << 20, "new");
+
+    std::size_t i = 0;
+    for (auto _ : state) {
+        if (i == paths.size()) {
+            state.SkipWithError("Ran out of paths");
+            break;
+        }
+        benchmark::DoNotOptimize(SettingManager::getSetting(paths[i++], sm));
+    }
+}
+BENCHMARK(BM_GetSettingNew)->Range(8, 64 << 10);
+
+// Looking up an already registered path in a registry of `range(0)` settings
+static void
+BM_GetSettingExisting(benchmark::State &state)
+{
+    auto sm = MakeManager();
+    auto existing = fillRegistry(sm, static_cast<std::size_t>(state.range(0)));
+    const auto &path = existing.back()->getPath();
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(SettingManager::getSetting(path, sm));
+    }
+}
+BENCHMARK(BM_GetSettingExisting)->Range(8, 64 << 10);
+
+// Constructing & destroying a Setting handle for an existing path
+static void
+BM_SettingConstruct(benchmark::State &state)
+{
+    auto sm = MakeManager();
+    auto existing = fillRegistry(sm, static_cast<std::size_t>(state.range(0)));
+    const auto &path = existing.back()->getPath();
+
+    for (auto _ : state) {
+        Setting<int> s(path, sm);
+        benchmark::DoNotOptimize(s.isValid());
+    }
+}
+BENCHMARK(BM_SettingConstruct)->Range(8, 64 << 10);
+
+// Constructing & destroying a Setting handle from a compile-time key
+static void
+BM_SettingConstructKey(benchmark::State &state)
+{
+    constexpr Key<"/registry-key/value", int> key;
+
+    auto sm = MakeManager();
+    auto existing = fillRegistry(sm, static_cast<std::size_t>(state.range(0)));
+    Setting<int> bound(key, sm);
+
+    for (auto _ : state) {
+        Setting<int> s(key, sm);
+        benchmark::DoNotOptimize(s.isValid());
+    }
+}
+BENCHMARK(BM_SettingConstructKey)->Range(8, 64 << 10);
+
+// Removing a setting from a registry of `range(0)` settings
+static void
+BM_RemoveSetting(benchmark::State &state)
+{
+    auto sm = MakeManager();
+    auto existing = fillRegistry(sm, static_cast<std::size_t>(state.range(0)));
+
+    const std::string path = "/registry-remove/value";
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        Setting<int> s(path, sm);
+        s = 1;
+        state.ResumeTiming();
+
+        benchmark::DoNotOptimize(sm->removeSetting(path));
+    }
+}
+BENCHMARK(BM_RemoveSetting)->Range(8, 64 << 10);
@@ -0,0 +1,89 @@
+#include <benchmark/benchmark.h>
+
+#include <pajlada/settings.hpp>
+#include <string>
+#include <vector>
+
+#include "generate.hpp"
+
+using namespace pajlada::Settings;
+
+static void
+BM_SetValue(benchmark::State &state)
+{
+    auto sm = MakeManager();
+    Setting<int> a("/bench/setvalue/int", sm);
+
+    int i = 0;
+    for (auto _ : state) {
+        a.setValue(++i);
+    }
+}
+BENCHMARK(BM_SetValue);
+
+static void
+BM_SetValueFlat(benchmark::State &state)
+{
+    auto sm = MakeManager();
+    Setting<int> a("/bench/setvalue/flat", SettingOption::FlatStorage, sm);
+
+    int i = 0;
+    for (auto _ : state) {
+        a.setValue(++i);
+    }
+}
+BENCHMARK(BM_SetValueFlat);
+
+// With CompareBeforeSet, setting the same value again is skipped
+static void
+BM_SetValueCompareBeforeSetUnchanged(benchmark::State &state)
+{
+    auto sm = MakeManager();
+    Setting<int> a("/bench/setvalue/compare-unchanged", 5,
+                   SettingOption::CompareBeforeSet, sm);
+    a = 5;
+
+    for (auto _ : state) {
+        a.setValue(5);
+    }
+}
+BENCHMARK(BM_SetValueCompareBeforeSetUnchanged);
+
+static void
+BM_SetValueCompareBeforeSetChanged(benchmark::State &state)
+{
+    auto sm = MakeManager();
+    Setting<int> a("/bench/setvalue/compare-changed",
+                   SettingOption::CompareBeforeSet, sm);
+
+    int i = 0;
+    for (auto _ : state) {
+        a.setValue(++i);
+    }
+}
+BENCHMARK(BM_SetValueCompareBeforeSetChanged);
+
+// Setting a vector of `range(0)` strings
+// range(1) toggles CompareBeforeSet. The value never changes, so with
+// CompareBeforeSet enabled the set is always skipped
+static void
+BM_SetValueVector(benchmark::State &state)
+{
+    auto sm = MakeManager();
+    auto options = state.range(1) != 0 ? SettingOption::CompareBeforeSet
+                                       : SettingOption::Default;
+    Setting<std::vector<std::string>> a("/bench/setvalue/vector", options,
+                                        sm);
+
+    std::vector<std::string> values(static_cast<std::size_t>(state.range(0)),
+                                    "highlight phrase");
+    a = values;
+
+    for (auto _ : state) {
+        a.setValue(values);
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_SetValueVector)
+    ->ArgsProduct({benchmark::CreateRange(8, 8 << 10, 8), {0, 1}});
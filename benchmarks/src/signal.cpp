@@ -0,0 +1,67 @@
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <pajlada/settings.hpp>
+#include <vector>
+
+#include "generate.hpp"
+
+using namespace pajlada::Settings;
+
+// Changing a setting with `range(0)` connected listeners
+static void
+BM_SignalFanOut(benchmark::State &state)
+{
+    auto sm = MakeManager();
+    Setting<int> a("/bench/signal/fan-out", sm);
+
+    std::vector<std::unique_ptr<pajlada::Signals::ScopedConnection>>
+        connections;
+    int64_t invocations = 0;
+
+    for (int64_t i = 0; i < state.range(0); ++i) {
+        a.connect(
+            [&invocations](const int &value) {
+                invocations += value;
+            },
+            connections, false);
+    }
+
+    int i = 0;
+    for (auto _ : state) {
+        a.setValue(++i % 2);
+    }
+
+    benchmark::DoNotOptimize(invocations);
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_SignalFanOut)->RangeMultiplier(4)->Range(1, 1 << 10);
+
+// Same as BM_SignalFanOut, but with listeners that don't deserialize the value
+static void
+BM_SignalFanOutSimple(benchmark::State &state)
+{
+    auto sm = MakeManager();
+    Setting<int> a("/bench/signal/fan-out-simple", sm);
+
+    std::vector<std::unique_ptr<pajlada::Signals::ScopedConnection>>
+        connections;
+    int64_t invocations = 0;
+
+    for (int64_t i = 0; i < state.range(0); ++i) {
+        a.connectSimple(
+            [&invocations](const SignalArgs &) {
+                ++invocations;
+            },
+            connections, false);
+    }
+
+    int i = 0;
+    for (auto _ : state) {
+        a.setValue(++i % 2);
+    }
+
+    benchmark::DoNotOptimize(invocations);
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_SignalFanOutSimple)->RangeMultiplier(4)->Range(1, 1 << 10);
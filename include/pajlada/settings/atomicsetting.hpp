@@ -0,0 +1,181 @@
+#pragma once
+
+#include <memory>
+#include <pajlada/settings/detail/flatstorage.hpp>
+#include <pajlada/settings/key.hpp>
+#include <pajlada/settings/pathtable.hpp>
+#include <pajlada/settings/settingdata.hpp>
+#include <pajlada/settings/settingmanager.hpp>
+#include <pajlada/settings/signalargs.hpp>
+#include <string>
+
+namespace pajlada::Settings {
+
+/// A bool or arithmetic setting that can be read from any thread without locking
+///
+/// The value lives in the setting's FlatStorage slot, which is shared with
+/// every AtomicSetting & every Setting using SettingOption::FlatStorage at the
+/// same path. Once the value has been read from the document, getValue is an
+/// atomic load: no mutex, no weak_ptr::lock & no update iteration check.
+/// The first read after a load, or after a write through the document (e.g.
+/// a Setting without FlatStorage), reads the document again.
+///
+/// Writes behave like Setting::setValue with SettingOption::FlatStorage.
+/// Listeners can be connected through a Setting at the same path.
+///
+/// An AtomicSetting keeps its setting registered, so it's never dropped by
+/// SettingManager::compactRegistry. After its path has been removed from the
+/// registry (removeSetting, clear), it keeps working on its own & should be
+/// recreated to share its value with new Settings at the path again.
+///
+/// On a frozen manager, an AtomicSetting at a path that wasn't registered
+/// before freezing is invalid & reads its default value.
+template <typename Type>
+class AtomicSetting
+{
+    static_assert(detail::IsFlatStorable<Type>,
+                  "AtomicSetting only supports bool & arithmetic types");
+
+public:
+    explicit AtomicSetting(const std::string &_path,
+                           std::shared_ptr<SettingManager> instance = nullptr)
+        : AtomicSetting(
+              SettingManager::getSettingHandle(_path, instance),
+              Type{})
+    {
+    }
+
+    explicit AtomicSetting(const std::string &_path, Type _defaultValue,
+                           std::shared_ptr<SettingManager> instance = nullptr)
+        : AtomicSetting(
+              SettingManager::getSettingHandle(_path, instance),
+              _defaultValue)
+    {
+    }
+
+    template <detail::FixedString KeyPath>
+    explicit AtomicSetting(Key<KeyPath, Type> key,
+                           std::shared_ptr<SettingManager> instance = nullptr)
+        : AtomicSetting(
+              SettingManager::getSettingHandle(key.binding(), instance),
+              Type{})
+    {
+    }
+
+    template <detail::FixedString KeyPath>
+    explicit AtomicSetting(Key<KeyPath, Type> key, Type _defaultValue,
+                           std::shared_ptr<SettingManager> instance = nullptr)
+        : AtomicSetting(
+              SettingManager::getSettingHandle(key.binding(), instance),
+              _defaultValue)
+    {
+    }
+
+    AtomicSetting(const AtomicSetting &) = default;
+    AtomicSetting &operator=(const AtomicSetting &) = delete;
+
+    bool
+    isValid() const
+    {
+        return this->data != nullptr;
+    }
+
+    const std::string &
+    getPath() const
+    {
+        return this->getPathID().str();
+    }
+
+    PathID
+    getPathID() const
+    {
+        if (!this->data) {
+            return {};
+        }
+
+        return this->data->getPathID();
+    }
+
+    Type
+    getValue() const
+    {
+        if (!this->data) {
+            return this->defaultValue;
+        }
+
+        if (this->slot != nullptr) {
+            // Writers to the document refill the slot, so this never reads
+            // the document
+            return this->data->template unmarshalFlat<Type>(*this->slot)
+                .value_or(this->defaultValue);
+        }
+
+        // Another kind of FlatStorage setting took the slot first
+        return this->data->template unmarshal<Type>().value_or(
+            this->defaultValue);
+    }
+
+    operator Type() const
+    {
+        return this->getValue();
+    }
+
+    bool
+    setValue(Type newValue, SignalArgs &&args = SignalArgs())
+    {
+        if (!this->data) {
+            return false;
+        }
+
+        if (args.source == SignalArgs::Source::Unset) {
+            args.source = SignalArgs::Source::Setter;
+        }
+
+        if (this->slot != nullptr && args.writeToFile && !args.resetToDefault) {
+            return this->data->marshalFlat(*this->slot, newValue,
+                                           std::move(args));
+        }
+
+        return this->data->marshal(newValue, std::move(args));
+    }
+
+    AtomicSetting &
+    operator=(Type newValue)
+    {
+        this->setValue(newValue);
+
+        return *this;
+    }
+
+    void
+    resetToDefaultValue(SignalArgs &&args = SignalArgs())
+    {
+        args.resetToDefault = true;
+        this->setValue(this->defaultValue, std::move(args));
+    }
+
+    Type
+    getDefaultValue() const
+    {
+        return this->defaultValue;
+    }
+
+private:
+    AtomicSetting(const detail::SettingDataHandle &handle, Type _defaultValue)
+        : data(handle.lock())
+        , slot(this->data ? this->data->template getFlatSlot<Type>() : nullptr)
+        , defaultValue(_defaultValue)
+    {
+    }
+
+    /// Strong, so the slot can't be released & reused while we read it
+    /// nullptr if the path wasn't registered before the manager was frozen
+    const std::shared_ptr<SettingData> data;
+
+    /// nullptr if the slot was acquired for a different kind of value
+    detail::FlatSlot *const slot;
+
+    const Type defaultValue;
+};
+
+}  // namespace pajlada::Settings
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <pajlada/settings/signalargs.hpp>
+#include <pajlada/signals/scoped-connection.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace pajlada {
+
+/// A SettingListener that collects the paths of changed settings and invokes
+/// its callback once per batch instead of once per change.
+///
+/// A batch is delivered:
+///  - when a Transaction ends
+///  - when SettingManager::setMany has notified all the settings it changed
+///  - when the time window (if any) has passed since the first change of the batch
+///  - when flush is called
+///
+/// With no time window and no open Transaction, every change is delivered right away.
+///
+/// If a time window is used, the callback is invoked from the listener's own timer thread.
+class CoalescingSettingListener
+{
+public:
+    using Callback = std::function<void(const std::vector<std::string> &)>;
+
+    /// Keeps the listener from delivering any batches until it's destroyed.
+    /// Transactions can be nested; the batch is delivered when the outermost one ends.
+    class Transaction
+    {
+        CoalescingSettingListener *listener;
+
+    public:
+        explicit Transaction(CoalescingSettingListener &_listener);
+        ~Transaction();
+
+        Transaction(Transaction &&other) noexcept;
+        Transaction &operator=(Transaction &&other) = delete;
+        Transaction(const Transaction &) = delete;
+        Transaction &operator=(const Transaction &) = delete;
+    };
+
+    CoalescingSettingListener() = default;
+
+    explicit CoalescingSettingListener(
+        Callback callback,
+        std::chrono::milliseconds _window = std::chrono::milliseconds::zero());
+
+    ~CoalescingSettingListener();
+
+    CoalescingSettingListener(CoalescingSettingListener &&other) = delete;
+    CoalescingSettingListener &operator=(CoalescingSettingListener &&other) =
+        delete;
+    CoalescingSettingListener(const CoalescingSettingListener &) = delete;
+    CoalescingSettingListener &operator=(const CoalescingSettingListener &) =
+        delete;
+
+    void setCB(Callback callback);
+    void resetCB();
+
+    // templated function that can take any sort of pajlada::Setting
+    template <typename AnySetting>
+    void
+    addSetting(AnySetting &setting)
+    {
+        auto path = setting.getPath();
+        setting.connectSimple(
+            [this, path](const Settings::SignalArgs &) {
+                this->markChanged(path);  //
+            },
+            this->managedConnections, false);
+    }
+
+    /// Add the given path to the current batch
+    void markChanged(const std::string &path);
+
+    /// Deliver the current batch, if there is one
+    ///
+    /// If another thread is delivering batches, waits for it to finish, so
+    /// every change made before the call has been delivered once it returns.
+    /// Called from within the callback, the change is delivered right after
+    /// the callback returns instead.
+    void flush();
+
+    [[nodiscard]] Transaction transaction();
+
+private:
+    void beginTransaction();
+    void endTransaction();
+
+    void runTimer();
+
+    std::mutex cbMutex;
+    Callback cb;
+
+    const std::chrono::milliseconds window{};
+
+    std::mutex stateMutex;
+    std::condition_variable stateChanged;
+    std::vector<std::string> pending;
+    std::optional<std::chrono::steady_clock::time_point> deadline;
+    int transactionDepth = 0;
+    /// Set while we hold a transaction open until a setMany batch ends
+    bool batchPending = false;
+    bool flushing = false;
+    bool stopping = false;
+    /// The thread delivering batches while `flushing` is set
+    std::thread::id flushingThread;
+    /// Notified when `flushing` is cleared
+    std::condition_variable flushDone;
+
+    std::thread timer;
+
+    /// Guards callbacks that may outlive the listener
+    ///
+    /// The destructor clears `alive` & waits for callbacks that are using the
+    /// listener to return
+    struct Lifetime {
+        std::mutex mutex;
+        std::condition_variable released;
+        bool alive = true;
+        int users = 0;
+    };
+    std::shared_ptr<Lifetime> lifetime = std::make_shared<Lifetime>();
+
+    std::vector<std::unique_ptr<Signals::ScopedConnection>> managedConnections;
+};
+
+}  // namespace pajlada
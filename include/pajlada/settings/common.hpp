@@ -28,9 +28,17 @@ enum class SettingOption : uint32_t {
     Remote = (1ULL << 2ULL),
 
     /// CompareBeforeSet compares the old & new value before updating the setting.
-    /// This compares the JSON value, so a marshal & compare to the existing JSON value takes place
+    /// If the setting has its current value cached & IsTypedComparable holds for the type, the values are
+    /// compared with IsEqual. Otherwise the new value is marshalled & compared to the existing JSON value
     CompareBeforeSet = (1ULL << 3ULL),
 
+    /// FlatStorage keeps the value of a bool or arithmetic setting in a typed slot next to the document.
+    /// Reads & writes through the setting skip the JSON pointer & (de)serialization, but still take the
+    /// setting's lock (see AtomicSetting for reads without locking). The value is written into the
+    /// document when it's saved, when the manager is frozen or by SettingManager::flushFlatStorage.
+    /// Ignored for other types, and for writes that don't write to JSON or reset to the default value.
+    FlatStorage = (1ULL << 4ULL),
+
     Default = 0,
 };
 
@@ -114,4 +122,12 @@ struct is_stl_container {
         is_stl_container_impl::is_stl_container<std::decay_t<T>>::value;
 };
 
+// std::maps with string keys, which are stored as JSON objects
+template <typename T>
+struct is_string_map : std::false_type {
+};
+template <typename... Args>
+struct is_string_map<std::map<std::string, Args...>> : std::true_type {
+};
+
 }  // namespace pajlada
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <rapidjson/document.h>
+
+#include <coroutine>
+#include <pajlada/settings/signalargs.hpp>
+
+namespace pajlada::Settings::detail {
+
+/// Intrusive list node for a coroutine waiting on the next change of a SettingData
+struct ChangeWaiter {
+    ChangeWaiter *next = nullptr;
+
+    /// Head of the list the waiter is in: the SettingData's waiters, or the
+    /// waiters a notification is about to resume. nullptr once it's resumed.
+    /// Guarded by the SettingData's waiter mutex.
+    ChangeWaiter **list = nullptr;
+
+    std::coroutine_handle<> handle;
+
+    /// Called right before the waiter is resumed, while the new value is still alive
+    void (*capture)(ChangeWaiter *self, const rapidjson::Value &value,
+                    const SignalArgs &args) = nullptr;
+};
+
+}  // namespace pajlada::Settings::detail
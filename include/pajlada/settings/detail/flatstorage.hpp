@@ -0,0 +1,196 @@
+#pragma once
+
+#include <rapidjson/document.h>
+#include <rapidjson/pointer.h>
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace pajlada::Settings::detail {
+
+/// Types whose values can be kept in a FlatSlot
+template <typename Type>
+concept IsFlatStorable = std::is_arithmetic_v<Type>;
+
+/// The value of one scalar setting, kept outside of the document
+struct FlatSlot {
+    enum class Kind : std::uint8_t {
+        Bool,
+        Int,
+        Uint,
+        Double,
+    };
+
+    enum class State : std::uint8_t {
+        /// The slot isn't in use, slots are filled from the document when they're acquired
+        Empty,
+        /// The document has no value at the setting's path
+        Unset,
+        /// `bits` holds the value in the document
+        Clean,
+        /// `bits` holds a value that hasn't been written to the document yet
+        Dirty,
+    };
+
+    std::atomic<std::uint64_t> bits{};
+    std::atomic<State> state{State::Empty};
+
+    Kind kind = Kind::Int;
+
+    /// The owning SettingData's pointer, only set while the slot is in use
+    const rapidjson::Pointer *pointer = nullptr;
+};
+
+template <IsFlatStorable Type>
+constexpr FlatSlot::Kind
+flatKind()
+{
+    if constexpr (std::is_same_v<Type, bool>) {
+        return FlatSlot::Kind::Bool;
+    } else if constexpr (std::is_floating_point_v<Type>) {
+        return FlatSlot::Kind::Double;
+    } else if constexpr (std::is_signed_v<Type>) {
+        return FlatSlot::Kind::Int;
+    } else {
+        return FlatSlot::Kind::Uint;
+    }
+}
+
+template <IsFlatStorable Type>
+std::uint64_t
+toFlatBits(Type value)
+{
+    constexpr auto kind = flatKind<Type>();
+
+    if constexpr (kind == FlatSlot::Kind::Bool) {
+        return value ? 1 : 0;
+    } else if constexpr (kind == FlatSlot::Kind::Double) {
+        return std::bit_cast<std::uint64_t>(static_cast<double>(value));
+    } else if constexpr (kind == FlatSlot::Kind::Int) {
+        return static_cast<std::uint64_t>(static_cast<std::int64_t>(value));
+    } else {
+        return static_cast<std::uint64_t>(value);
+    }
+}
+
+/// `bits` must come from toFlatBits of a type of the same kind
+template <IsFlatStorable Type>
+Type
+fromFlatBits(std::uint64_t bits)
+{
+    constexpr auto kind = flatKind<Type>();
+
+    if constexpr (kind == FlatSlot::Kind::Bool) {
+        return bits != 0;
+    } else if constexpr (kind == FlatSlot::Kind::Double) {
+        return static_cast<Type>(std::bit_cast<double>(bits));
+    } else if constexpr (kind == FlatSlot::Kind::Int) {
+        return static_cast<Type>(static_cast<std::int64_t>(bits));
+    } else {
+        return static_cast<Type>(bits);
+    }
+}
+
+/// Typed storage for the settings of a SettingManager that use SettingOption::FlatStorage
+///
+/// Slots live in a deque so they never move, and are reused once their
+/// SettingData is gone. Reading a slot is lock-free, changing it takes the
+/// storage's mutex. Dirty slots are written into the document by `flush`.
+class FlatStorage
+{
+public:
+    static rapidjson::Value toJSON(FlatSlot::Kind kind, std::uint64_t bits);
+
+    /// The bits of `value` read as `kind`
+    ///
+    /// Like Deserialize, a value of another type reads as 0 or false
+    static std::uint64_t fromJSON(FlatSlot::Kind kind,
+                                  const rapidjson::Value &value);
+
+    /// Acquire a slot filled with the value at `pointer` in `document`
+    ///
+    /// `pointer` must stay alive until the slot is released
+    FlatSlot *acquire(FlatSlot::Kind kind, const rapidjson::Pointer *pointer,
+                      const rapidjson::Value &document);
+
+    /// A dirty value that has not been flushed yet is lost
+    void release(FlatSlot *slot);
+
+    /// Point a slot at the new pointer of its moved setting
+    ///
+    /// `pointer` must stay alive until the slot is released or moved again
+    void move(FlatSlot &slot, const rapidjson::Pointer *pointer);
+
+    /// Store a new value, to be written to the document on the next flush
+    ///
+    /// If `compare` is set and the slot already holds `bits`, nothing is
+    /// stored & false is returned
+    bool store(FlatSlot &slot, std::uint64_t bits, bool compare);
+
+    /// Read the values of the slots at, inside or above `changed` from
+    /// `document` again, after `changed` has been written to through it
+    ///
+    /// If `changed` is nullptr, all slots are read again, e.g. after the
+    /// document was replaced. Otherwise the slots are looked up by path, so
+    /// the cost doesn't grow with the number of unrelated slots.
+    /// Dirty values of those slots are lost, the write replaced them.
+    ///
+    /// Called by the writer, so readers of a slot never have to read the
+    /// document themselves
+    void reload(const rapidjson::Value &document,
+                const rapidjson::Pointer *changed = nullptr);
+
+    /// Write all dirty values into `document`
+    ///
+    /// If `inside` is set, only the values at or inside it are written
+    ///
+    /// Returns the number of values written
+    std::size_t flush(rapidjson::Document &document,
+                      const rapidjson::Pointer *inside = nullptr);
+
+    /// Number of slots in use
+    std::size_t size() const;
+
+    /// True if no slot is in use, without locking
+    bool
+    empty() const
+    {
+        return this->used.load(std::memory_order_relaxed) == 0;
+    }
+
+private:
+    /// Fill `slot` with the value at its pointer, must hold `mutex`
+    static void read(FlatSlot &slot, const rapidjson::Value &document);
+
+    /// Remove `slot` from `slotsByPath`, must hold `mutex`
+    void unindex(FlatSlot &slot);
+
+    mutable std::mutex mutex;
+
+    std::deque<FlatSlot> slots;
+    std::vector<FlatSlot *> freeSlots;
+
+    /// Slots in use by the tokens of their pointer, see pathKey
+    ///
+    /// The key of a path is a prefix of the keys of the paths inside it
+    std::multimap<std::string, FlatSlot *, std::less<>> slotsByPath;
+
+    /// May contain released or already flushed slots, flush skips those
+    std::vector<FlatSlot *> dirtySlots;
+
+    /// Set while dirtySlots is non-empty, lets flush skip the lock
+    std::atomic<bool> dirty{false};
+
+    std::atomic<std::size_t> used{0};
+};
+
+}  // namespace pajlada::Settings::detail
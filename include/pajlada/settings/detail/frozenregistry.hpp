@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace pajlada::Settings {
+
+class SettingData;
+
+namespace detail {
+
+/// Immutable path -> SettingData table built by SettingManager::freeze
+///
+/// Uses hash & displace perfect hashing: the path's hash picks a bucket, and
+/// the bucket's seed, chosen at build time, maps every path in the bucket to
+/// its own entry. A lookup hashes the path once & compares one entry.
+/// Buckets for which no seed is found (e.g. two paths with the same hash) are
+/// looked up in a sorted overflow table instead.
+/// Lookups don't lock, but the table must not be rebuilt while it's in use.
+class FrozenRegistry
+{
+public:
+    using Registry =
+        std::map<std::string_view, std::shared_ptr<SettingData>, std::less<>>;
+
+    /// Number of seeds tried per bucket before it goes to the overflow table
+    static constexpr std::uint32_t DEFAULT_MAX_SEED = 1 << 16;
+
+    /// Keys must stay alive as long as the table
+    void build(const Registry &registry,
+               std::uint32_t maxSeed = DEFAULT_MAX_SEED);
+
+    /// Returns nullptr if `path` was not in the registry when it was built
+    const std::shared_ptr<SettingData> *find(std::string_view path) const;
+
+    std::size_t
+    size() const
+    {
+        return this->entries.size() + this->overflow.size();
+    }
+
+    /// Number of paths in the overflow table
+    std::size_t
+    overflowSize() const
+    {
+        return this->overflow.size();
+    }
+
+private:
+    struct Entry {
+        std::string_view path;
+        std::shared_ptr<SettingData> setting;
+    };
+
+    /// Seed of a bucket whose paths are in the overflow table
+    static constexpr std::uint32_t OVERFLOW_SEED = UINT32_MAX;
+
+    static std::uint64_t indexHash(std::uint64_t hash, std::uint32_t seed);
+
+    std::vector<std::uint32_t> seeds;
+    std::vector<Entry> entries;
+
+    /// Sorted by path
+    std::vector<Entry> overflow;
+};
+
+}  // namespace detail
+
+}  // namespace pajlada::Settings
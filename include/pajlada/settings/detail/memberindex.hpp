@@ -0,0 +1,63 @@
+#pragma once
+
+#include <rapidjson/document.h>
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+
+namespace pajlada::Settings::detail {
+
+/// Hash indexes over the members of large objects in a document
+///
+/// rapidjson looks members up with a linear scan. Objects with at least
+/// `threshold` members get a name -> position table the first time a
+/// member is looked up through here. The table is extended when members
+/// are appended, and rebuilt when the object's member storage was
+/// reallocated or members were removed.
+///
+/// Names in the tables point into the document, so `clear` must be called
+/// whenever values may have been removed from, or swapped around in the
+/// document (removals, loads, array edits).
+class MemberIndex
+{
+public:
+    /// Same as `object.FindMember(name)`, returns nullptr if there's no member
+    /// `object` must be an object
+    rapidjson::Value *find(rapidjson::Value &object, std::string_view name);
+
+    /// Same as `object.RemoveMember(name)`, keeping the object's table up to date
+    ///
+    /// Like RemoveMember, the last member is moved into the removed one's place.
+    /// Returns false if there's no member
+    bool remove(rapidjson::Value &object, std::string_view name);
+
+    /// Forget every table
+    void clear();
+
+    /// Minimum number of members an object needs to be indexed, 0 disables indexing
+    void setThreshold(std::size_t threshold);
+
+    /// Number of objects with a table
+    std::size_t size() const;
+
+private:
+    struct Table {
+        /// The first member when the table was last updated
+        const rapidjson::Value::Member *members = nullptr;
+        rapidjson::SizeType count = 0;
+        std::unordered_map<std::string_view, rapidjson::SizeType> positions;
+    };
+
+    static rapidjson::Value *findLinear(rapidjson::Value &object,
+                                        std::string_view name);
+
+    std::atomic<std::size_t> threshold{0};
+
+    mutable std::mutex mutex;
+    std::unordered_map<const rapidjson::Value *, Table> tables;
+};
+
+}  // namespace pajlada::Settings::detail
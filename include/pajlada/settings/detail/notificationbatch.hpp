@@ -0,0 +1,30 @@
+#pragma once
+
+#include <functional>
+
+namespace pajlada::Settings::detail {
+
+/// Open while SettingManager::setMany notifies the settings it changed
+///
+/// Batches are per thread & can be nested, callbacks given to `onEnd` run
+/// when the outermost batch ends.
+class NotificationBatch
+{
+public:
+    NotificationBatch();
+    ~NotificationBatch();
+
+    NotificationBatch(const NotificationBatch &) = delete;
+    NotificationBatch &operator=(const NotificationBatch &) = delete;
+    NotificationBatch(NotificationBatch &&) = delete;
+    NotificationBatch &operator=(NotificationBatch &&) = delete;
+
+    /// True if a batch is open on this thread
+    static bool isOpen();
+
+    /// Run `callback` when the batch open on this thread ends, or right away
+    /// if there's none
+    static void onEnd(std::function<void()> callback);
+};
+
+}  // namespace pajlada::Settings::detail
@@ -1,7 +1,12 @@
 #pragma once
 
 #include <any>
+#include <concepts>
 #include <map>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <variant>
 #include <vector>
 
 namespace pajlada {
@@ -114,4 +119,47 @@ struct IsEqual<std::vector<std::any>> {
     }
 };
 
+/// True if IsEqual<Type> compares values the same way as their JSON
+///
+/// SettingOption::CompareBeforeSet compares such values with IsEqual, & the
+/// JSON of other types. Specialize to std::false_type for types whose
+/// operator== ignores parts of the value that are serialized.
+template <typename Type>
+struct IsTypedComparable
+    : std::bool_constant<std::equality_comparable<Type>> {
+};
+
+template <>
+struct IsTypedComparable<std::any> : std::false_type {
+};
+
+// The standard comparison operators of these aren't constrained on their
+// contents, so check the contents instead
+template <typename Type1, typename Type2>
+struct IsTypedComparable<std::pair<Type1, Type2>>
+    : std::bool_constant<IsTypedComparable<Type1>::value &&
+                         IsTypedComparable<Type2>::value> {
+};
+
+template <typename ValueType>
+struct IsTypedComparable<std::optional<ValueType>>
+    : IsTypedComparable<ValueType> {
+};
+
+template <typename... Types>
+struct IsTypedComparable<std::variant<Types...>>
+    : std::bool_constant<(IsTypedComparable<Types>::value && ...)> {
+};
+
+template <typename ValueType, typename... Args>
+struct IsTypedComparable<std::vector<ValueType, Args...>>
+    : IsTypedComparable<ValueType> {
+};
+
+template <typename KeyType, typename ValueType, typename... Args>
+struct IsTypedComparable<std::map<KeyType, ValueType, Args...>>
+    : std::bool_constant<IsTypedComparable<KeyType>::value &&
+                         IsTypedComparable<ValueType>::value> {
+};
+
 }  // namespace pajlada
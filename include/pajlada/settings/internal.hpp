@@ -6,7 +6,10 @@
 #include <rapidjson/prettywriter.h>  // IWYU pragma: keep
 #include <rapidjson/writer.h>        // IWYU pragma: keep
 
-#include <iostream>  // IWYU pragma: keep
+#include <iostream>                     // IWYU pragma: keep
+#include <pajlada/settings/trace.hpp>  // IWYU pragma: keep
+#include <sstream>                     // IWYU pragma: keep
+#include <string>                      // IWYU pragma: keep
 
 #endif
 
@@ -23,7 +26,25 @@ pp(const rapidjson::Value &v)
     return {buffer.GetString()};
 }
 
-#define PS_DEBUG(x) std::cout << x << '\n';
+/// Debug messages go to the trace sink as instant events if one is set,
+/// otherwise they're printed to stdout
+inline void
+debug(std::string message)
+{
+    if (Trace::isEnabled()) {
+        Trace::instant("debug", std::move(message), "settings.debug");
+        return;
+    }
+
+    std::cout << message << '\n';
+}
+
+#define PS_DEBUG(x)                                                    \
+    do {                                                               \
+        std::ostringstream psDebugStream;                              \
+        psDebugStream << x;                                            \
+        ::pajlada::Settings::internal::debug(psDebugStream.str());     \
+    } while (false)
 #else
 #define PS_DEBUG(x)
 #endif
@@ -0,0 +1,202 @@
+#pragma once
+
+#include <rapidjson/pointer.h>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <pajlada/settings/pathtable.hpp>
+#include <string_view>
+
+namespace pajlada::Settings {
+
+namespace detail {
+
+/// String literal usable as a template argument
+template <std::size_t N>
+struct FixedString {
+    char chars[N]{};
+
+    // NOLINTNEXTLINE(google-explicit-constructor)
+    constexpr FixedString(const char (&str)[N])
+    {
+        std::copy_n(str, N, this->chars);
+    }
+
+    constexpr std::string_view
+    view() const
+    {
+        return {this->chars, N - 1};
+    }
+};
+
+constexpr std::uint64_t
+fnv1a(std::string_view str)
+{
+    std::uint64_t hash = 14695981039346656037ULL;
+    for (char c : str) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+constexpr std::size_t
+countPathTokens(std::string_view path)
+{
+    return static_cast<std::size_t>(std::count(path.begin(), path.end(), '/'));
+}
+
+constexpr bool
+isValidKeyPath(std::string_view path)
+{
+    if (path.empty()) {
+        return true;
+    }
+
+    if (path.front() != '/') {
+        return false;
+    }
+
+    // Only ~0 & ~1 are valid escapes
+    for (std::size_t i = 0; i < path.size(); ++i) {
+        if (path[i] == '~' && (i + 1 == path.size() ||
+                               (path[i + 1] != '0' && path[i + 1] != '1'))) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/// The tokens of a JSON pointer, unescaped & null-terminated one after another
+template <std::size_t N>
+constexpr std::array<char, N>
+unescapePathTokens(std::string_view path)
+{
+    std::array<char, N> buffer{};
+    std::size_t out = 0;
+
+    // Skip the leading '/'
+    for (std::size_t i = 1; i < path.size(); ++i) {
+        if (path[i] == '/') {
+            buffer[out++] = '\0';
+        } else if (path[i] == '~') {
+            buffer[out++] = path[++i] == '0' ? '~' : '/';
+        } else {
+            buffer[out++] = path[i];
+        }
+    }
+
+    return buffer;
+}
+
+/// Same rules as rapidjson::Pointer's parser: digits only, no leading zero
+constexpr rapidjson::SizeType
+tokenIndex(std::string_view token)
+{
+    constexpr auto invalid = rapidjson::kPointerInvalidIndex;
+
+    if (token.empty() || (token.size() > 1 && token.front() == '0')) {
+        return invalid;
+    }
+
+    std::uint64_t index = 0;
+    for (char c : token) {
+        if (c < '0' || c > '9') {
+            return invalid;
+        }
+        index = index * 10 + static_cast<std::uint64_t>(c - '0');
+        if (index >= invalid) {
+            return invalid;
+        }
+    }
+
+    return static_cast<rapidjson::SizeType>(index);
+}
+
+template <FixedString Path>
+struct KeyPath {
+    static_assert(isValidKeyPath(Path.view()),
+                  "A setting key must be a JSON pointer, e.g. \"/a/b\"");
+
+    static constexpr std::string_view path = Path.view();
+
+    static constexpr std::size_t TOKEN_COUNT = countPathTokens(path);
+
+    // Unescaping only ever shrinks the path, +1 for the last terminator
+    static constexpr auto buffer =
+        unescapePathTokens<sizeof(Path.chars)>(path);
+
+    static constexpr std::array<rapidjson::Pointer::Token, TOKEN_COUNT>
+        tokens = [] {
+            std::array<rapidjson::Pointer::Token, TOKEN_COUNT> result{};
+            std::size_t offset = 0;
+            for (auto &token : result) {
+                std::string_view name(&buffer[offset]);
+                token.name = &buffer[offset];
+                token.length = static_cast<rapidjson::SizeType>(name.size());
+                token.index = tokenIndex(name);
+                offset += name.size() + 1;
+            }
+            return result;
+        }();
+};
+
+/// Hands out the dense per-Key index into each SettingManager's key table
+std::uint32_t nextKeySlot();
+
+/// What a SettingManager needs to bind a Key to its SettingData
+struct KeyBinding {
+    std::uint32_t slot;
+    PathID path;
+    const rapidjson::Pointer *pointer;
+};
+
+}  // namespace detail
+
+/// A setting path known at compile time, e.g.
+///   constexpr Key<"/appearance/fontSize", int> fontSize;
+///   Setting<int> setting(fontSize);
+///
+/// The JSON pointer tokens & hash of the path are computed at compile time.
+/// The first Setting created from a key in a SettingManager binds the key to a
+/// slot in the manager's flat key table, later ones skip the path lookup.
+template <detail::FixedString Path, typename Type>
+struct Key {
+    using ValueType = Type;
+
+    static constexpr std::string_view path = detail::KeyPath<Path>::path;
+    static constexpr std::uint64_t hash = detail::fnv1a(path);
+
+    /// Pointer over the compile-time tokens, doesn't parse or allocate
+    static const rapidjson::Pointer &
+    pointer()
+    {
+        static const rapidjson::Pointer p(
+            detail::KeyPath<Path>::tokens.data(),
+            detail::KeyPath<Path>::tokens.size());
+        return p;
+    }
+
+    static PathID
+    pathID()
+    {
+        static const PathID id = PathID::intern(path);
+        return id;
+    }
+
+    static detail::KeyBinding
+    binding()
+    {
+        static const std::uint32_t slot = detail::nextKeySlot();
+        return {
+            .slot = slot,
+            .path = pathID(),
+            .pointer = &pointer(),
+        };
+    }
+};
+
+}  // namespace pajlada::Settings
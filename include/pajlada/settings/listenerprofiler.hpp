@@ -0,0 +1,74 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace pajlada::Settings {
+
+struct ListenerProfile {
+    std::string path;
+
+    /// Label the listener was connected with, empty for unlabelled listeners
+    std::string label;
+
+    std::uint64_t calls = 0;
+    std::chrono::nanoseconds total{};
+    std::chrono::nanoseconds max{};
+};
+
+/// Opt-in timing of every listener invoked by a SettingManager's settings
+///
+/// Time is attributed to the setting path and the label the listener was connected with.
+/// Only listeners connected while the profiler is enabled are timed, the others
+/// are invoked without any overhead.
+class ListenerProfiler
+{
+public:
+    using SlowCallback = std::function<void(const ListenerProfile &profile,
+                                            std::chrono::nanoseconds duration)>;
+
+    void setEnabled(bool enabled = true);
+
+    bool
+    isEnabled() const
+    {
+        return this->enabled.load(std::memory_order_relaxed);
+    }
+
+    /// Invoke `callback` every time a listener takes longer than `threshold`
+    ///
+    /// The callback is invoked on the thread that notified the listener,
+    /// right after the listener returns.
+    void setSlowThreshold(std::chrono::nanoseconds threshold,
+                          SlowCallback callback);
+
+    /// Returns up to `n` listeners, slowest single invocation first
+    std::vector<ListenerProfile> topSlowest(std::size_t n) const;
+
+    /// Forget everything recorded so far
+    void reset();
+
+    void record(const std::string &path, const std::string &label,
+                std::chrono::nanoseconds duration);
+
+private:
+    std::atomic<bool> enabled{false};
+
+    mutable std::mutex mutex;
+
+    //       path & label                          profile
+    std::map<std::pair<std::string, std::string>, ListenerProfile> entries;
+
+    std::chrono::nanoseconds slowThreshold{};
+    std::shared_ptr<const SlowCallback> slowCallback;
+};
+
+}  // namespace pajlada::Settings
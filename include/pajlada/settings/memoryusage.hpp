@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace pajlada::Settings {
+
+/// Memory used by a SettingManager, see SettingManager::memoryUsage
+///
+/// Byte counts of document values are estimates: they assume every string
+/// longer than RapidJSON's inline short string limit was copied into the pool.
+struct MemoryUsage {
+    struct Subtree {
+        std::string key;
+        std::size_t bytes = 0;
+    };
+
+    /// Bytes handed out by the document's MemoryPoolAllocator
+    std::size_t allocatorUsed = 0;
+    /// Bytes of all chunks held by the document's MemoryPoolAllocator
+    std::size_t allocatorCapacity = 0;
+
+    /// Estimated bytes of the pool still reachable from the document
+    std::size_t liveBytes = 0;
+    /// liveBytes / allocatorUsed
+    ///
+    /// The pool never frees memory, so overwritten & removed values stay
+    /// around as garbage until the document is replaced (e.g. by a load).
+    double liveRatio = 1.0;
+
+    /// Estimated bytes of each member of the document's root object
+    std::vector<Subtree> topLevel;
+
+    /// Number of SettingData in the registry
+    std::size_t settingCount = 0;
+    /// Bytes of the paths of the registry entries
+    ///
+    /// Paths are interned, so these bytes are shared with every Setting &
+    /// SignalArgs of the same path.
+    std::size_t settingPathBytes = 0;
+
+    /// Number of paths in the process-wide PathTable, shared by all managers
+    std::size_t internedPaths = 0;
+    /// Bytes of the strings in the process-wide PathTable
+    std::size_t internedPathBytes = 0;
+
+    /// Number of listeners connected to the settings
+    std::size_t listenerCount = 0;
+};
+
+}  // namespace pajlada::Settings
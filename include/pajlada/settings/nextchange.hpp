@@ -0,0 +1,99 @@
+#pragma once
+
+#include <rapidjson/document.h>
+
+#include <coroutine>
+#include <memory>
+#include <optional>
+#include <pajlada/serialize.hpp>
+#include <pajlada/settings/detail/changewaiter.hpp>
+#include <pajlada/settings/settingdata.hpp>
+#include <pajlada/settings/signalargs.hpp>
+#include <utility>
+
+namespace pajlada::Settings {
+
+template <typename Type>
+struct SettingChange {
+    Type value{};
+    SignalArgs args;
+};
+
+/// Awaitable returned by Setting::nextChange
+///
+/// The awaiting coroutine is resumed on the thread that changed the setting,
+/// right after the setting's regular listeners have been invoked.
+/// Waiting does not allocate, the awaiter itself is the list node.
+///
+/// If the setting is no longer valid, the coroutine is not suspended and
+/// receives a default-constructed value.
+///
+/// A suspended coroutine may be destroyed while a change is being delivered
+/// to other waiters, it won't be resumed. Destroying it on one thread while
+/// another thread is resuming it is a race, like for any coroutine.
+template <typename Type>
+class NextChangeAwaiter : private detail::ChangeWaiter
+{
+public:
+    explicit NextChangeAwaiter(std::shared_ptr<SettingData> _data)
+        : data(std::move(_data))
+    {
+        this->capture = &NextChangeAwaiter::onChange;
+    }
+
+    ~NextChangeAwaiter()
+    {
+        if (this->data) {
+            // No-op if we were already resumed
+            this->data->removeWaiter(this);
+        }
+    }
+
+    NextChangeAwaiter(NextChangeAwaiter &&other) = delete;
+    NextChangeAwaiter &operator=(NextChangeAwaiter &&other) = delete;
+    NextChangeAwaiter(const NextChangeAwaiter &) = delete;
+    NextChangeAwaiter &operator=(const NextChangeAwaiter &) = delete;
+
+    bool
+    await_ready() const noexcept
+    {
+        return !this->data;
+    }
+
+    void
+    await_suspend(std::coroutine_handle<> awaitingCoroutine)
+    {
+        this->handle = awaitingCoroutine;
+
+        // The coroutine may be resumed from another thread as soon as we're
+        // in the list, so nothing can touch `this` after this call
+        this->data->addWaiter(this);
+    }
+
+    SettingChange<Type>
+    await_resume()
+    {
+        if (!this->change) {
+            return {};
+        }
+
+        return std::move(*this->change);
+    }
+
+private:
+    static void
+    onChange(detail::ChangeWaiter *self, const rapidjson::Value &value,
+             const SignalArgs &args)
+    {
+        auto *awaiter = static_cast<NextChangeAwaiter *>(self);
+        awaiter->change.emplace(SettingChange<Type>{
+            .value = Deserialize<Type>::get(value),
+            .args = args,
+        });
+    }
+
+    std::shared_ptr<SettingData> data;
+    std::optional<SettingChange<Type>> change;
+};
+
+}  // namespace pajlada::Settings
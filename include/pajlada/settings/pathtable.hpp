@@ -0,0 +1,137 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace pajlada::Settings {
+
+/// Stable integer handle of an interned setting path
+///
+/// Two PathIDs are equal if and only if their paths are equal.
+/// A default-constructed PathID refers to the empty path.
+///
+/// A PathID is only valid while a reference to it is held, e.g. by the
+/// Setting or SettingData it was read from. Once its last reference is
+/// released, the ID can be reused for a different path.
+class PathID
+{
+public:
+    constexpr PathID() = default;
+
+    /// Intern `path` in the global PathTable and take a reference to it
+    static PathID intern(std::string_view path);
+
+    /// Take another reference to this path, returns the same PathID
+    PathID retain() const;
+
+    /// Release a reference taken by `intern` or `retain`
+    void release() const;
+
+    const std::string &str() const;
+
+    std::string_view
+    view() const
+    {
+        return this->str();
+    }
+
+    constexpr std::uint32_t
+    value() const
+    {
+        return this->id;
+    }
+
+    constexpr bool
+    empty() const
+    {
+        return this->id == 0;
+    }
+
+    friend constexpr bool operator==(PathID, PathID) = default;
+
+private:
+    friend class PathTable;
+
+    constexpr explicit PathID(std::uint32_t _id)
+        : id(_id)
+    {
+    }
+
+    std::uint32_t id = 0;
+};
+
+/// Process-wide table of interned setting paths
+///
+/// Paths are reference counted & removed once their last reference is
+/// released, their IDs are reused by later paths. The empty path is never
+/// removed. Looking up the string of a PathID is lock-free.
+class PathTable
+{
+public:
+    static PathTable &instance();
+
+    PathTable(const PathTable &) = delete;
+    PathTable &operator=(const PathTable &) = delete;
+    PathTable(PathTable &&) = delete;
+    PathTable &operator=(PathTable &&) = delete;
+
+    ~PathTable();
+
+    /// Returns the ID of `path`, adding it to the table if needed
+    ///
+    /// The caller holds a reference to the returned ID
+    PathID intern(std::string_view path);
+
+    void retain(PathID id);
+
+    /// Removes the path from the table if this was its last reference
+    void release(PathID id);
+
+    /// Returns the ID of `path` if it has been interned, or the empty PathID
+    ///
+    /// No reference is taken, the ID stays valid only as long as someone
+    /// else holds a reference to it
+    PathID find(std::string_view path) const;
+
+    const std::string &get(PathID id) const;
+
+    /// Number of interned paths that are still referenced
+    std::size_t size() const;
+
+    /// Bytes used by the interned path strings
+    std::size_t bytes() const;
+
+private:
+    PathTable();
+
+    /// Chunk `i` holds FIRST_CHUNK_SIZE << i paths, so chunks never move
+    static constexpr std::size_t FIRST_CHUNK_BITS = 10;
+    static constexpr std::size_t FIRST_CHUNK_SIZE = 1 << FIRST_CHUNK_BITS;
+    static constexpr std::size_t NUM_CHUNKS = 32 - FIRST_CHUNK_BITS + 1;
+
+    struct Entry {
+        std::string path;
+        std::atomic<std::uint32_t> refs{0};
+    };
+
+    Entry &entry(PathID id) const;
+
+    std::array<std::atomic<Entry *>, NUM_CHUNKS> chunks{};
+
+    mutable std::shared_mutex mutex;
+    std::unordered_map<std::string_view, std::uint32_t> ids;
+    std::uint32_t count = 0;
+    std::size_t stringBytes = 0;
+
+    /// IDs of removed paths, reused before new IDs are handed out
+    std::vector<std::uint32_t> freeIDs;
+};
+
+}  // namespace pajlada::Settings
@@ -2,11 +2,18 @@
 
 #include <rapidjson/document.h>
 
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <iterator>
 #include <memory>
 #include <mutex>
 #include <pajlada/settings/common.hpp>
 #include <pajlada/settings/equal.hpp>
 #include <pajlada/settings/internal.hpp>
+#include <pajlada/settings/key.hpp>
+#include <pajlada/settings/nextchange.hpp>
+#include <pajlada/settings/pathtable.hpp>
 #include <pajlada/settings/settingdata.hpp>
 #include <pajlada/settings/settingmanager.hpp>
 #include <pajlada/signals.hpp>
@@ -72,14 +79,17 @@ void connectToManager<Signals::SignalHolder>(Signals::SignalHolder &manager,
 template <typename Type>
 class Setting
 {
-    const std::string path;
+    /// The path the setting was created with
+    /// Settings inside an array element follow the element when it's moved,
+    /// see SettingManager::compactArray
+    const PathID path;
 
 public:
     explicit Setting(const std::string &_path,
                      SettingOption _options = SettingOption::Default,
                      std::shared_ptr<SettingManager> instance = nullptr)
-        : path(_path)
-        , data(SettingManager::getSetting(_path, instance))
+        : path(PathID::intern(_path))
+        , data(SettingManager::getSettingHandle(this->path, instance))
         , options(_options)
     {
     }
@@ -87,8 +97,8 @@ public:
     explicit Setting(const char *_path,
                      SettingOption _options = SettingOption::Default,
                      std::shared_ptr<SettingManager> instance = nullptr)
-        : path(_path)
-        , data(SettingManager::getSetting(_path, instance))
+        : path(PathID::intern(_path))
+        , data(SettingManager::getSettingHandle(this->path, instance))
         , options(_options)
     {
     }
@@ -96,8 +106,8 @@ public:
     explicit Setting(const std::string &_path, Type _defaultValue,
                      SettingOption _options = SettingOption::Default,
                      std::shared_ptr<SettingManager> instance = nullptr)
-        : path(_path)
-        , data(SettingManager::getSetting(_path, instance))
+        : path(PathID::intern(_path))
+        , data(SettingManager::getSettingHandle(this->path, instance))
         , options(_options)
         , defaultValue(std::move(_defaultValue))
     {
@@ -106,8 +116,8 @@ public:
     explicit Setting(const char *_path, Type _defaultValue,
                      SettingOption _options = SettingOption::Default,
                      std::shared_ptr<SettingManager> instance = nullptr)
-        : path(_path)
-        , data(SettingManager::getSetting(_path, instance))
+        : path(PathID::intern(_path))
+        , data(SettingManager::getSettingHandle(this->path, instance))
         , options(_options)
         , defaultValue(std::move(_defaultValue))
     {
@@ -115,42 +125,81 @@ public:
 
     explicit Setting(const std::string &_path,
                      std::shared_ptr<SettingManager> instance)
-        : path(_path)
-        , data(SettingManager::getSetting(_path, instance))
+        : path(PathID::intern(_path))
+        , data(SettingManager::getSettingHandle(this->path, instance))
     {
     }
 
     explicit Setting(const char *_path,
                      std::shared_ptr<SettingManager> instance)
-        : path(_path)
-        , data(SettingManager::getSetting(_path, instance))
+        : path(PathID::intern(_path))
+        , data(SettingManager::getSettingHandle(this->path, instance))
     {
     }
 
     explicit Setting(const std::string &_path, Type _defaultValue,
                      std::shared_ptr<SettingManager> instance)
-        : path(_path)
-        , data(SettingManager::getSetting(_path, instance))
+        : path(PathID::intern(_path))
+        , data(SettingManager::getSettingHandle(this->path, instance))
         , defaultValue(std::move(_defaultValue))
     {
     }
 
     explicit Setting(const char *_path, Type _defaultValue,
                      std::shared_ptr<SettingManager> instance)
-        : path(_path)
-        , data(SettingManager::getSetting(_path, instance))
+        : path(PathID::intern(_path))
+        , data(SettingManager::getSettingHandle(this->path, instance))
+        , defaultValue(std::move(_defaultValue))
+    {
+    }
+
+    template <detail::FixedString KeyPath>
+    explicit Setting(Key<KeyPath, Type> key,
+                     SettingOption _options = SettingOption::Default,
+                     std::shared_ptr<SettingManager> instance = nullptr)
+        : path(key.pathID().retain())
+        , data(SettingManager::getSettingHandle(key.binding(), instance))
+        , options(_options)
+    {
+    }
+
+    template <detail::FixedString KeyPath>
+    explicit Setting(Key<KeyPath, Type> key, Type _defaultValue,
+                     SettingOption _options = SettingOption::Default,
+                     std::shared_ptr<SettingManager> instance = nullptr)
+        : path(key.pathID().retain())
+        , data(SettingManager::getSettingHandle(key.binding(), instance))
+        , options(_options)
+        , defaultValue(std::move(_defaultValue))
+    {
+    }
+
+    template <detail::FixedString KeyPath>
+    explicit Setting(Key<KeyPath, Type> key,
+                     std::shared_ptr<SettingManager> instance)
+        : path(key.pathID().retain())
+        , data(SettingManager::getSettingHandle(key.binding(), instance))
+    {
+    }
+
+    template <detail::FixedString KeyPath>
+    explicit Setting(Key<KeyPath, Type> key, Type _defaultValue,
+                     std::shared_ptr<SettingManager> instance)
+        : path(key.pathID().retain())
+        , data(SettingManager::getSettingHandle(key.binding(), instance))
         , defaultValue(std::move(_defaultValue))
     {
     }
 
     // Copy constructor
     Setting(const Setting &other)
-        : path(other.path)
+        : path(other.path.retain())
         , data(other.data)
         , options(other.options)
         , defaultValue(other.defaultValue)
         , value(other.value)
         , updateIteration(other.updateIteration)
+        , valueFrozen(other.valueFrozen.load(std::memory_order_acquire))
     {
         // managedConnections is not copied on purpose
         // valueMutex is not copied on purpose
@@ -162,7 +211,10 @@ public:
         return (this->options & option) == option;
     }
 
-    ~Setting() = default;
+    ~Setting()
+    {
+        this->path.release();
+    }
 
     bool
     isValid() const
@@ -173,6 +225,16 @@ public:
     const std::string &
     getPath() const
     {
+        return this->getPathID().str();
+    }
+
+    PathID
+    getPathID() const
+    {
+        if (auto lockedData = this->data.lock()) {
+            return lockedData->getPathID();
+        }
+
         return this->path;
     }
 
@@ -185,10 +247,36 @@ public:
     const Type &
     getValue() const
     {
+        // Once read from a frozen manager, the value can't change anymore
+        if (this->valueFrozen.load(std::memory_order_acquire)) {
+            if (this->value) {
+                return *this->value;
+            }
+
+            return this->defaultValue;
+        }
+
         PS_DEBUG("Setting::getValue('" << this->getPath() << "')");
         std::unique_lock<std::mutex> lock(this->valueMutex);
 
-        const auto res = this->checkValueForUpdates();
+        if constexpr (detail::IsFlatStorable<Type>) {
+            auto lockedSetting = this->data.lock();
+            if (auto *slot = this->flatSlot(lockedSetting.get())) {
+                const auto frozen = lockedSetting->isFrozen();
+                lockedSetting->stats().getCalls.add();
+                this->value = lockedSetting->unmarshalFlat<Type>(*slot);
+                if (frozen) {
+                    this->valueFrozen.store(true, std::memory_order_release);
+                }
+                if (this->value) {
+                    return *this->value;
+                }
+
+                return this->defaultValue;
+            }
+        }
+
+        const auto res = this->checkValueForUpdates(true);
         if (res == CheckResult::InvalidSetting) {
             if (this->value) {
                 return *this->value;
@@ -246,21 +334,75 @@ public:
     }
 
     // Implement vector helper stuff
+    //
+    // push_back, insert, removeAt & removeByValue only write the changed
+    // element to the document. Listeners get the whole container with
+    // SignalArgs::Change::ElementInserted or ElementErased & the element's
+    // index in SignalArgs::index.
     template <typename T = Type,
               typename = std::enable_if_t<is_stl_container<T>::value>>
     void
     push_back(typename T::value_type newItem, SignalArgs &&args = SignalArgs())
     {
-        // TODO(pajlada): refresh this->value first?
-        this->valueMutex.lock();
-        if (!this->value) {
-            this->value = Type{};
-        }
+        std::size_t index = 0;
+
+        this->updateIncrementally(
+            [&](Type &container) {
+                index = container.size();
+                container.push_back(newItem);
+                return true;
+            },
+            [&](SettingData &setting, SignalArgs &&writeArgs) {
+                return setting.insertElement(index, newItem,
+                                             std::move(writeArgs));
+            },
+            std::move(args));
+    }
 
-        (*this->value).push_back(std::move(newItem));
-        auto copy = *this->value;
-        this->valueMutex.unlock();
-        this->updateValue(copy, std::move(args));
+    /// Insert `newItem` before the element at `index`
+    ///
+    /// Returns false if `index` is past the end of the container
+    template <typename T = Type,
+              typename = std::enable_if_t<is_stl_container<T>::value>>
+    bool
+    insert(std::size_t index, typename T::value_type newItem,
+           SignalArgs &&args = SignalArgs())
+    {
+        return this->updateIncrementally(
+            [&](Type &container) {
+                if (index > container.size()) {
+                    return false;
+                }
+                container.insert(std::next(container.begin(), index), newItem);
+                return true;
+            },
+            [&](SettingData &setting, SignalArgs &&writeArgs) {
+                return setting.insertElement(index, newItem,
+                                             std::move(writeArgs));
+            },
+            std::move(args));
+    }
+
+    /// Remove the element at `index`
+    ///
+    /// Returns false if `index` is past the end of the container
+    template <typename T = Type,
+              typename = std::enable_if_t<is_stl_container<T>::value>>
+    bool
+    removeAt(std::size_t index, SignalArgs &&args = SignalArgs())
+    {
+        return this->updateIncrementally(
+            [&](Type &container) {
+                if (index >= container.size()) {
+                    return false;
+                }
+                container.erase(std::next(container.begin(), index));
+                return true;
+            },
+            [&](SettingData &setting, SignalArgs &&writeArgs) {
+                return setting.eraseElement(index, std::move(writeArgs));
+            },
+            std::move(args));
     }
 
     template <typename T = Type,
@@ -269,37 +411,348 @@ public:
     removeByValue(const typename T::value_type &key,
                   SignalArgs &&args = SignalArgs())
     {
-        // TODO(pajlada): refresh this->value first?
+        std::size_t index = 0;
+
+        // Set if more than one element matched, then the whole value is written
+        std::optional<Type> copy;
+
+        this->updateIncrementally(
+            [&](Type &container) {
+                auto it = std::find(container.begin(), container.end(), key);
+                if (it == container.end()) {
+                    // nothing was removed
+                    return false;
+                }
+
+                if (std::find(std::next(it), container.end(), key) !=
+                    container.end()) {
+                    container.erase(
+                        std::remove(it, container.end(), key),
+                        container.end());
+                    copy = container;
+                    return true;
+                }
+
+                index = std::distance(container.begin(), it);
+                container.erase(it);
+                return true;
+            },
+            [&](SettingData &setting, SignalArgs &&writeArgs) {
+                if (copy) {
+                    return setting.marshal(*copy, std::move(writeArgs));
+                }
+
+                return setting.eraseElement(index, std::move(writeArgs));
+            },
+            std::move(args));
+    }
 
-        T copy;
+    /// Set the value of `key` in the map, only writing that member to the document
+    ///
+    /// Listeners get the whole map with SignalArgs::Change::MemberAssigned
+    /// & the key in SignalArgs::key.
+    template <typename T = Type,
+              typename = std::enable_if_t<is_string_map<T>::value>>
+    bool
+    insertOrAssign(const std::string &key, typename T::mapped_type newItem,
+                   SignalArgs &&args = SignalArgs())
+    {
+        return this->updateIncrementally(
+            [&](Type &map) {
+                map.insert_or_assign(key, newItem);
+                return true;
+            },
+            [&](SettingData &setting, SignalArgs &&writeArgs) {
+                return setting.marshalMember(key, newItem,
+                                             std::move(writeArgs));
+            },
+            std::move(args));
+    }
 
-        {
-            std::unique_lock<std::mutex> lock(this->valueMutex);
-            if (!this->value) {
-                return;
+    /// Remove `key` from the map, only removing that member from the document
+    ///
+    /// Listeners get the whole map with SignalArgs::Change::MemberErased
+    /// & the key in SignalArgs::key.
+    /// Returns false if the map doesn't contain `key`
+    template <typename T = Type,
+              typename = std::enable_if_t<is_string_map<T>::value>>
+    bool
+    erase(const std::string &key, SignalArgs &&args = SignalArgs())
+    {
+        return this->updateIncrementally(
+            [&](Type &map) {
+                return map.erase(key) != 0;
+            },
+            [&](SettingData &setting, SignalArgs &&writeArgs) {
+                return setting.eraseMember(key, std::move(writeArgs));
+            },
+            std::move(args));
+    }
+
+    /// Change the value in place with `modify`
+    ///
+    /// `modify` gets the current value, or the default value if it's unset.
+    /// The value is serialized & listeners are notified once.
+    /// Updates through any Setting at this path run one at a time, so none of
+    /// them are lost. `modify` must not change a Setting at this path, the
+    /// listeners may, they run once the lock has been released.
+    bool
+    update(const std::function<void(Type &)> &modify,
+           SignalArgs &&args = SignalArgs())
+    {
+        return this->readModifyWrite(
+            [&](Type &value) {
+                modify(value);
+                return true;
+            },
+            std::move(args));
+    }
+
+    /// Set the value to `desired` if it's currently equal to `expected`
+    ///
+    /// Runs under the same lock as update, so of several threads expecting
+    /// the same value only one succeeds, the others can read the value again
+    /// & retry. Returns false if the value wasn't `expected`
+    bool
+    compareAndSet(const Type &expected, const Type &desired,
+                  SignalArgs &&args = SignalArgs())
+    {
+        return this->readModifyWrite(
+            [&](Type &value) {
+                if (!IsEqual<Type>::get(value, expected)) {
+                    return false;
+                }
+                value = desired;
+                return true;
+            },
+            std::move(args));
+    }
+
+    /// Add `delta` to the value & return the value it had before
+    ///
+    /// Runs under the same lock as update, so concurrent increments through
+    /// any Setting at this path aren't lost. With SettingOption::FlatStorage
+    /// only the setting's slot is changed, otherwise the number is
+    /// overwritten in the document without serializing anything else.
+    ///
+    /// Listeners are notified of every change, use a
+    /// CoalescingSettingListener with a time window to get one callback for
+    /// many increments.
+    template <typename T = Type,
+              typename = std::enable_if_t<std::is_arithmetic_v<T> &&
+                                          !std::is_same_v<T, bool>>>
+    Type
+    fetchAdd(Type delta, SignalArgs &&args = SignalArgs())
+    {
+        if (this->managerFrozen()) {
+            return this->getValue();
+        }
+
+        auto lockedSetting = this->data.lock();
+        if (!lockedSetting) {
+            // Returns the cached or default value
+            return this->getValue();
+        }
+
+        auto *slot = this->flatSlot(lockedSetting.get());
+        if (slot != nullptr && args.writeToFile &&
+            !this->optionEnabled(SettingOption::DoNotWriteToJSON)) {
+            if (args.source == SignalArgs::Source::Unset) {
+                args.source = SignalArgs::Source::Setter;
             }
 
-            copy = (*this->value);
+            auto updateLock = lockedSetting->lockForUpdate();
+
+            const auto previous =
+                lockedSetting->template unmarshalFlat<Type>(*slot).value_or(
+                    this->defaultValue);
+            lockedSetting->marshalFlat(*slot, addWrapping(previous, delta),
+                                       std::move(args));
+
+            return previous;
         }
 
-        auto valueSize = copy.size();
+        Type previous{};
+        this->readModifyWrite(
+            [&](Type &value) {
+                previous = value;
+                value = addWrapping(value, delta);
+                return true;
+            },
+            std::move(args));
 
-        copy.erase(std::remove(copy.begin(), copy.end(), key), copy.end());
+        return previous;
+    }
 
-        if (copy.size() == valueSize) {
-            // nothing was removed
-            return;
+private:
+    /// `a + b`, wrapping around instead of overflowing for integers
+    static Type
+    addWrapping(Type a, Type b)
+    {
+        if constexpr (std::is_integral_v<Type>) {
+            using Unsigned = std::make_unsigned_t<Type>;
+            return static_cast<Type>(static_cast<Unsigned>(a) +
+                                     static_cast<Unsigned>(b));
+        } else {
+            return static_cast<Type>(a + b);
         }
+    }
 
-        {
-            this->valueMutex.lock();
-            this->value = copy;
-            this->valueMutex.unlock();
-            this->updateValue(copy, std::move(args));
+    /// Implements update, compareAndSet & fetchAdd
+    ///
+    /// `modify` returns false if the value should be left as it is
+    template <typename Modify>
+    bool
+    readModifyWrite(Modify &&modify, SignalArgs &&args)
+    {
+        if (this->managerFrozen()) {
+            return false;
         }
+
+        auto lockedSetting = this->data.lock();
+        if (!lockedSetting) {
+            return false;
+        }
+
+        if (this->optionEnabled(SettingOption::CompareBeforeSet)) {
+            args.compareBeforeSet = true;
+        }
+
+        if (this->optionEnabled(SettingOption::DoNotWriteToJSON)) {
+            args.writeToFile = false;
+        }
+
+        if (args.source == SignalArgs::Source::Unset) {
+            args.source = SignalArgs::Source::Setter;
+        }
+
+        auto updateLock = lockedSetting->lockForUpdate();
+
+        std::unique_lock<std::mutex> lock(this->valueMutex);
+        // Picks up the previous update if it went through another Setting
+        this->checkValueForUpdates();
+
+        if (!this->value) {
+            auto newValue = this->defaultValue;
+            if (!modify(newValue)) {
+                return false;
+            }
+            this->value = std::move(newValue);
+        } else if (!modify(*this->value)) {
+            return false;
+        }
+        const auto readIteration = this->updateIteration;
+
+        // Unlocks before the listeners are notified
+        if (!lockedSetting->marshal(*this->value, lock, std::move(args))) {
+            lock.lock();
+            if (this->updateIteration == readIteration) {
+                // The document wasn't changed, read it again on the next get
+                this->updateIteration = -1;
+            }
+            return false;
+        }
+
+        lock.lock();
+        if (this->updateIteration == readIteration &&
+            lockedSetting->getUpdateIteration() == readIteration + 1) {
+            // Our write was the only change, the cached value is up to date
+            this->updateIteration = readIteration + 1;
+        }
+
+        return true;
+    }
+
+    /// Apply `modify` to the cached value & `write` just the change to the document
+    ///
+    /// `modify` returns false if it didn't change the value. If the value
+    /// isn't in the document (unset or DoNotWriteToJSON), `modify` starts
+    /// from an empty container & the result is set with setValue instead.
+    /// setValue is also used if `write` fails, e.g. because the document
+    /// holds something else than a container at this path.
+    /// The cached value is kept if no other change got in between, so the
+    /// next getValue doesn't deserialize the whole value again.
+    /// Runs under the same lock as update, so the helpers & updates through
+    /// any Setting at this path don't lose each other's changes.
+    template <typename Modify, typename Write>
+    bool
+    updateIncrementally(Modify &&modify, Write &&write, SignalArgs &&args)
+    {
+        if (this->managerFrozen()) {
+            return false;
+        }
+
+        auto lockedSetting = this->data.lock();
+        if (!lockedSetting) {
+            return false;
+        }
+
+        if (this->optionEnabled(SettingOption::CompareBeforeSet)) {
+            args.compareBeforeSet = true;
+        }
+
+        if (args.source == SignalArgs::Source::Unset) {
+            args.source = SignalArgs::Source::Setter;
+        }
+
+        auto updateLock = lockedSetting->lockForUpdate();
+
+        std::unique_lock<std::mutex> lock(this->valueMutex);
+        // Picks up the previous update if it went through another Setting
+        this->checkValueForUpdates();
+
+        if (!this->value ||
+            this->optionEnabled(SettingOption::DoNotWriteToJSON)) {
+            // There's nothing in the document to change in place
+            auto newValue = this->value.value_or(Type{});
+            if (!modify(newValue)) {
+                return false;
+            }
+            lock.unlock();
+
+            return this->setValue(newValue, std::move(args));
+        }
+
+        if (!modify(*this->value)) {
+            return false;
+        }
+        const auto readIteration = this->updateIteration;
+        lock.unlock();
+
+        auto written = write(*lockedSetting, SignalArgs(args));
+        lock.lock();
+
+        if (!written) {
+            if (this->updateIteration != readIteration ||
+                lockedSetting->getUpdateIteration() != readIteration) {
+                // Someone else changed the value, read it again on the next get
+                this->updateIteration = -1;
+                return false;
+            }
+
+            // The document can't be changed in place, write the whole value.
+            // Not through setValue, the cache already holds the new value so
+            // its CompareBeforeSet check would skip the write
+            if (!lockedSetting->marshal(*this->value, lock, std::move(args))) {
+                lock.lock();
+                if (this->updateIteration == readIteration) {
+                    // The document wasn't changed, read it again on the next get
+                    this->updateIteration = -1;
+                }
+                return false;
+            }
+            lock.lock();
+        }
+
+        if (this->updateIteration == readIteration &&
+            lockedSetting->getUpdateIteration() == readIteration + 1) {
+            // Our write was the only change, the cached value is up to date
+            this->updateIteration = readIteration + 1;
+        }
+
+        return true;
     }
 
-private:
     bool
     updateValue(const Type &newValue, SignalArgs &&args)
     {
@@ -325,6 +778,11 @@ public:
     {
         assert(this->isValid());
 
+        if (this->managerFrozen()) {
+            // Don't let our local value diverge from the document
+            return false;
+        }
+
         if (this->optionEnabled(SettingOption::CompareBeforeSet)) {
             args.compareBeforeSet = true;
         }
@@ -334,6 +792,11 @@ public:
             if (args.resetToDefault) {
                 this->value.reset();
             } else {
+                if (args.compareBeforeSet &&
+                    this->cachedValueEquals(newValue)) {
+                    // Unchanged, no need to serialize the new value
+                    return false;
+                }
                 this->value = newValue;
             }
         }
@@ -348,6 +811,16 @@ public:
             if (args.source == SignalArgs::Source::Unset) {
                 args.source = SignalArgs::Source::Setter;
             }
+
+            if constexpr (detail::IsFlatStorable<Type>) {
+                auto *slot = this->flatSlot(lockedSetting.get());
+                if (slot != nullptr && args.writeToFile &&
+                    !args.resetToDefault) {
+                    return lockedSetting->marshalFlat(*slot, newValue,
+                                                      std::move(args));
+                }
+            }
+
             return lockedSetting->marshal(newValue, std::move(args));
         }
 
@@ -463,7 +936,7 @@ public:
     }
 
 private:
-    std::weak_ptr<SettingData> data;
+    detail::SettingDataHandle data;
     SettingOption options = SettingOption::Default;
     Type defaultValue{};
 
@@ -472,6 +945,9 @@ private:
     mutable std::optional<Type> value;
     mutable int updateIteration = -1;
 
+    /// Set once `value` has been read from a frozen manager, getValue stops locking
+    mutable std::atomic<bool> valueFrozen{false};
+
 public:
     std::weak_ptr<SettingData>
     getData()
@@ -479,26 +955,43 @@ public:
         return this->data;
     }
 
+    /// Like getData, but the returned handle keeps the entry from being
+    /// dropped by SettingManager::compactRegistry
+    detail::SettingDataHandle
+    getDataHandle()
+    {
+        return this->data;
+    }
+
+    /// Returns an awaitable that suspends the awaiting coroutine until the
+    /// next change of this setting, e.g.
+    ///   auto [value, args] = co_await setting.nextChange();
+    NextChangeAwaiter<Type>
+    nextChange() const
+    {
+        return NextChangeAwaiter<Type>(this->data.lock());
+    }
+
+    // Every connect overload takes an optional `label`, which the manager's
+    // ListenerProfiler attributes the listener's time to
+
     // ConnectJSON: Connect with rapidjson::Value and SignalArgs as arguments
     // No deserialization is made by the setting
     void
     connectJSON(
         std::function<void(const rapidjson::Value &, const SignalArgs &)> func,
-        bool autoInvoke = true)
+        bool autoInvoke = true, std::string label = {})
     {
         auto lockedSetting = this->data.lock();
         if (!lockedSetting) {
             return;
         }
 
-        auto connection = lockedSetting->updated.connect(func);
+        auto connection = lockedSetting->connect(func, std::move(label));
 
         if (autoInvoke) {
-            auto ptr = lockedSetting->unmarshalJSON();
             rapidjson::Document d;
-            if (ptr != nullptr) {
-                d.CopyFrom(*ptr, d.GetAllocator());
-            }
+            lockedSetting->copyJSON(d);
             lockedSetting->updated.invoke(d, detail::onConnectArgs());
         }
 
@@ -511,21 +1004,18 @@ public:
     connectJSON(
         std::function<void(const rapidjson::Value &, const SignalArgs &)> func,
         ConnectionManager &userDefinedManagedConnections,
-        bool autoInvoke = true)
+        bool autoInvoke = true, std::string label = {})
     {
         auto lockedSetting = this->data.lock();
         if (!lockedSetting) {
             return;
         }
 
-        auto connection = lockedSetting->updated.connect(func);
+        auto connection = lockedSetting->connect(func, std::move(label));
 
         if (autoInvoke) {
-            auto ptr = lockedSetting->unmarshalJSON();
             rapidjson::Document d;
-            if (ptr != nullptr) {
-                d.CopyFrom(*ptr, d.GetAllocator());
-            }
+            lockedSetting->copyJSON(d);
             lockedSetting->updated.invoke(d, detail::onConnectArgs());
         }
 
@@ -536,17 +1026,18 @@ public:
     // Connect: Value and SignalArgs
     void
     connect(std::function<void(const Type &, const SignalArgs &)> func,
-            bool autoInvoke = true)
+            bool autoInvoke = true, std::string label = {})
     {
         auto lockedSetting = this->data.lock();
         if (!lockedSetting) {
             return;
         }
 
-        auto connection = lockedSetting->updated.connect(
+        auto connection = lockedSetting->connect(
             [=](const rapidjson::Value &value, const SignalArgs &args) {
                 func(Deserialize<Type>::get(value), args);  //
-            });
+            },
+            std::move(label));
 
         if (autoInvoke) {
             func(this->getValue(), detail::onConnectArgs());
@@ -560,17 +1051,18 @@ public:
     void
     connect(std::function<void(const Type &, const SignalArgs &)> func,
             ConnectionManager &userDefinedManagedConnections,
-            bool autoInvoke = true)
+            bool autoInvoke = true, std::string label = {})
     {
         auto lockedSetting = this->data.lock();
         if (!lockedSetting) {
             return;
         }
 
-        auto connection = lockedSetting->updated.connect(
+        auto connection = lockedSetting->connect(
             [=](const rapidjson::Value &value, const SignalArgs &args) {
                 func(Deserialize<Type>::get(value), args);  //
-            });
+            },
+            std::move(label));
 
         if (autoInvoke) {
             func(this->getValue(), detail::onConnectArgs());
@@ -582,17 +1074,19 @@ public:
 
     // Connect: Value
     void
-    connect(std::function<void(const Type &)> func, bool autoInvoke = true)
+    connect(std::function<void(const Type &)> func, bool autoInvoke = true,
+            std::string label = {})
     {
         auto lockedSetting = this->data.lock();
         if (!lockedSetting) {
             return;
         }
 
-        auto connection = lockedSetting->updated.connect(
+        auto connection = lockedSetting->connect(
             [=](const rapidjson::Value &value, const SignalArgs &) {
                 func(Deserialize<Type>::get(value));  //
-            });
+            },
+            std::move(label));
 
         if (autoInvoke) {
             func(this->getValue());
@@ -606,17 +1100,18 @@ public:
     void
     connect(std::function<void(const Type &)> func,
             ConnectionManager &userDefinedManagedConnections,
-            bool autoInvoke = true)
+            bool autoInvoke = true, std::string label = {})
     {
         auto lockedSetting = this->data.lock();
         if (!lockedSetting) {
             return;
         }
 
-        auto connection = lockedSetting->updated.connect(
+        auto connection = lockedSetting->connect(
             [=](const rapidjson::Value &value, const SignalArgs &) {
                 func(Deserialize<Type>::get(value));  //
-            });
+            },
+            std::move(label));
 
         if (autoInvoke) {
             func(this->getValue());
@@ -628,17 +1123,19 @@ public:
 
     // Connect: no args
     void
-    connect(std::function<void()> func, bool autoInvoke = true)
+    connect(std::function<void()> func, bool autoInvoke = true,
+            std::string label = {})
     {
         auto lockedSetting = this->data.lock();
         if (!lockedSetting) {
             return;
         }
 
-        auto connection = lockedSetting->updated.connect(
+        auto connection = lockedSetting->connect(
             [=](const rapidjson::Value &, const SignalArgs &) {
                 func();  //
-            });
+            },
+            std::move(label));
 
         if (autoInvoke) {
             func();
@@ -652,17 +1149,18 @@ public:
     void
     connect(std::function<void()> func,
             ConnectionManager &userDefinedManagedConnections,
-            bool autoInvoke = true)
+            bool autoInvoke = true, std::string label = {})
     {
         auto lockedSetting = this->data.lock();
         if (!lockedSetting) {
             return;
         }
 
-        auto connection = lockedSetting->updated.connect(
+        auto connection = lockedSetting->connect(
             [=](const rapidjson::Value &, const SignalArgs &) {
                 func();  //
-            });
+            },
+            std::move(label));
 
         if (autoInvoke) {
             func();
@@ -675,17 +1173,18 @@ public:
     // ConnectSimple: Signal args only
     void
     connectSimple(std::function<void(const SignalArgs &)> func,
-                  bool autoInvoke = true)
+                  bool autoInvoke = true, std::string label = {})
     {
         auto lockedSetting = this->data.lock();
         if (!lockedSetting) {
             return;
         }
 
-        auto connection = lockedSetting->updated.connect(
+        auto connection = lockedSetting->connect(
             [=](const rapidjson::Value &, const SignalArgs &args) {
                 func(args);  //
-            });
+            },
+            std::move(label));
 
         if (autoInvoke) {
             func(detail::onConnectArgs());
@@ -699,17 +1198,18 @@ public:
     void
     connectSimple(std::function<void(const SignalArgs &)> func,
                   ConnectionManager &userDefinedManagedConnections,
-                  bool autoInvoke = true)
+                  bool autoInvoke = true, std::string label = {})
     {
         auto lockedSetting = this->data.lock();
         if (!lockedSetting) {
             return;
         }
 
-        auto connection = lockedSetting->updated.connect(
+        auto connection = lockedSetting->connect(
             [=](const rapidjson::Value &, const SignalArgs &args) {
                 func(args);  //
-            });
+            },
+            std::move(label));
 
         if (autoInvoke) {
             func(detail::onConnectArgs());
@@ -766,13 +1266,64 @@ public:
     }
 
 private:
+    bool
+    managerFrozen() const
+    {
+        auto lockedSetting = this->data.lock();
+
+        return lockedSetting && lockedSetting->isFrozen();
+    }
+
+    /// The slot to read & write through if FlatStorage is enabled for this setting
+    detail::FlatSlot *
+    flatSlot(SettingData *setting) const
+    {
+        if constexpr (detail::IsFlatStorable<Type>) {
+            if (setting != nullptr &&
+                this->optionEnabled(SettingOption::FlatStorage)) {
+                return setting->getFlatSlot<Type>();
+            }
+        }
+
+        return nullptr;
+    }
+
+    /// True if the value is known to be `newValue` without serializing it
+    ///
+    /// Compares with IsEqual if the type supports it & the setting has a
+    /// value, otherwise returns false so the JSON values are compared.
+    /// Must be called with valueMutex held
+    bool
+    cachedValueEquals(const Type &newValue) const
+    {
+        if constexpr (IsTypedComparable<Type>::value) {
+            auto lockedSetting = this->data.lock();
+            if (!lockedSetting) {
+                return false;
+            }
+
+            if (this->flatSlot(lockedSetting.get()) != nullptr) {
+                // The slot compares the values itself
+                return false;
+            }
+
+            this->checkValueForUpdates();
+
+            return this->value && IsEqual<Type>::get(*this->value, newValue);
+        } else {
+            return false;
+        }
+    }
+
     enum class CheckResult : std::uint8_t {
         InvalidSetting,
         NothingChanged,
         Updated,
     };
+    /// `countAsRead` is set by getValue, so only actual reads are counted in
+    /// the manager's getCalls & not the checks made before writes
     CheckResult
-    checkValueForUpdates() const
+    checkValueForUpdates(bool countAsRead = false) const
     {
         auto lockedSetting = this->data.lock();
 
@@ -780,8 +1331,18 @@ private:
             return CheckResult::InvalidSetting;
         }
 
+        if (countAsRead) {
+            lockedSetting->stats().getCalls.add();
+        }
+
+        // Checked first, so nothing can have changed the value after we read it
+        const auto frozen = lockedSetting->isFrozen();
+
         auto currentUpdateIteration = lockedSetting->getUpdateIteration();
         if (this->updateIteration == currentUpdateIteration) {
+            if (frozen) {
+                this->valueFrozen.store(true, std::memory_order_release);
+            }
             return CheckResult::NothingChanged;
         }
 
@@ -802,6 +1363,10 @@ private:
             this->value.reset();
         }
 
+        if (frozen) {
+            this->valueFrozen.store(true, std::memory_order_release);
+        }
+
         return CheckResult::Updated;
     }
 
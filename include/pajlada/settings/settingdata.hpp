@@ -6,34 +6,95 @@
 #include <atomic>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <pajlada/serialize.hpp>
 #include <pajlada/settings/common.hpp>
+#include <pajlada/settings/detail/changewaiter.hpp>
+#include <pajlada/settings/detail/flatstorage.hpp>
 #include <pajlada/settings/equal.hpp>
 #include <pajlada/settings/internal.hpp>
+#include <pajlada/settings/listenerprofiler.hpp>
+#include <pajlada/settings/pathtable.hpp>
 #include <pajlada/settings/settingmanager.hpp>
 #include <pajlada/settings/signalargs.hpp>
+#include <pajlada/settings/stats.hpp>
 #include <pajlada/signals/signal.hpp>
 #include <string>
+#include <thread>
 #include <vector>
 
 namespace pajlada::Settings {
 
+namespace detail {
+
+class SettingDataHandle;
+
+}  // namespace detail
+
 class SettingData
 {
-    SettingData(std::string _path, std::weak_ptr<SettingManager> _instance);
+    /// If `_pointer` is set, its tokens must outlive the SettingData
+    SettingData(PathID _path, const std::shared_ptr<SettingManager> &_instance,
+                const rapidjson::Pointer *_pointer = nullptr);
 
     // Setting path (i.e. /a/b/c/3/d/e)
-    const std::string path;
+    // Changes when the SettingManager moves the array element the setting is in
+    std::atomic<PathID> path;
+
+    /// `path` as a JSON pointer, parsed once
+    ///
+    /// Replaced by relocate & loaded by getPointer without locking. The
+    /// replaced pointer lives until the next relocate, a reader would have to
+    /// race two array edits to see it freed, which already races on the
+    /// document itself.
+    std::unique_ptr<const rapidjson::Pointer> ownedPointer;
+    std::atomic<const rapidjson::Pointer *> pointer;
+    std::unique_ptr<const rapidjson::Pointer> retiredPointer;
+    /// Held by relocate & while a flat slot is acquired
+    std::mutex pointerMutex;
 
     std::weak_ptr<SettingManager> instance;
 
     std::atomic<int> updateIteration{};
 
+    const std::shared_ptr<detail::ManagerStats> statistics;
+    const std::shared_ptr<ListenerProfiler> profiler;
+    const std::shared_ptr<detail::FlatStorage> flatStorage;
+    const std::shared_ptr<const std::atomic<bool>> frozen;
+
+    /// Acquired from `flatStorage` by the first read or write through a FlatStorage setting
+    std::atomic<detail::FlatSlot *> flatSlot{nullptr};
+
+    mutable std::mutex listenersMutex;
+
+    /// Connections made through `connect`, pruned once they're disconnected
+    mutable std::vector<Signals::Connection> listeners;
+
+    /// Number of live Setting handles pointing at this data
+    std::atomic<std::size_t> handleCount{};
+
 public:
-    Signals::Signal<const rapidjson::Value &, const SignalArgs &> updated;
+    ~SettingData();
+
+    using UpdatedSignal =
+        Signals::Signal<const rapidjson::Value &, const SignalArgs &>;
+
+    /// Listeners connected here directly aren't counted, so compactRegistry
+    /// may drop the entry while they're connected. Prefer `connect`
+    UpdatedSignal updated;
 
     const std::string &getPath() const;
 
+    PathID getPathID() const;
+
+    /// Connect a listener to the setting's updated signal
+    ///
+    /// Listeners connected through here are counted in the notifyUpdate trace span.
+    /// If the manager's ListenerProfiler is enabled when the listener is connected,
+    /// its invocations are timed under `label`
+    Signals::Connection connect(UpdatedSignal::FunctionSignature slot,
+                                std::string label = {});
+
     void notifyUpdate(const rapidjson::Value &value, SignalArgs args);
 
     bool
@@ -44,7 +105,7 @@ public:
             return false;
         }
 
-        return locked->set(this->path, v, std::move(args));
+        return locked->set(*this, v, std::move(args));
     }
 
     template <typename Type>
@@ -59,19 +120,129 @@ public:
         auto jsonValue =
             Serialize<Type>::get(v, locked->document.GetAllocator());
 
-        return locked->set(this->path, jsonValue, std::move(args));
+        return locked->set(*this, jsonValue, std::move(args));
+    }
+
+    /// Same as marshal, releasing `valueLock`, which guards `v`, as soon as
+    /// `v` has been serialized
+    template <typename Type>
+    bool
+    marshal(const Type &v, std::unique_lock<std::mutex> &valueLock,
+            SignalArgs args)
+    {
+        auto locked = this->instance.lock();
+        if (!locked) {
+            valueLock.unlock();
+            return false;
+        }
+
+        auto jsonValue =
+            Serialize<Type>::get(v, locked->document.GetAllocator());
+        valueLock.unlock();
+
+        return locked->set(*this, jsonValue, std::move(args));
+    }
+
+    /// Lock held by Setting::update & the container helpers for their whole
+    /// read-modify-write, so updates through any Setting at this path can't
+    /// overwrite each other
+    ///
+    /// notifyUpdate releases it before the listeners run, so a listener can
+    /// update the setting again
+    class UpdateLock
+    {
+    public:
+        explicit UpdateLock(SettingData &_setting);
+        ~UpdateLock();
+
+        UpdateLock(const UpdateLock &) = delete;
+        UpdateLock &operator=(const UpdateLock &) = delete;
+
+    private:
+        SettingData &setting;
+    };
+
+    UpdateLock
+    lockForUpdate()
+    {
+        return UpdateLock(*this);
+    }
+
+    /// Add or assign the member `key` of this object setting
+    template <typename Type>
+    bool
+    marshalMember(std::string_view key, const Type &v, SignalArgs args)
+    {
+        auto locked = this->instance.lock();
+        if (!locked) {
+            return false;
+        }
+
+        auto jsonValue =
+            Serialize<Type>::get(v, locked->document.GetAllocator());
+
+        return locked->setMember(*this, key, jsonValue, std::move(args));
+    }
+
+    /// Remove the member `key` from this object setting
+    bool eraseMember(std::string_view key, SignalArgs args);
+
+    /// Insert an element before `index` in this array setting
+    template <typename Type>
+    bool
+    insertElement(std::size_t index, const Type &v, SignalArgs args)
+    {
+        auto locked = this->instance.lock();
+        if (!locked) {
+            return false;
+        }
+
+        auto jsonValue =
+            Serialize<Type>::get(v, locked->document.GetAllocator());
+
+        return locked->insertArrayValue(
+            this->getPath(), this->getPointer(),
+            static_cast<rapidjson::SizeType>(index), jsonValue,
+            std::move(args));
     }
 
+    /// Remove the element at `index` from this array setting
+    bool eraseElement(std::size_t index, SignalArgs args);
+
     rapidjson::Value *
     unmarshalJSON()
     {
         return this->get();
     }
 
+    /// Copy the value into `out`, leaving it null if there's no value
+    ///
+    /// Unlike unmarshalJSON, this sees FlatStorage values that haven't been
+    /// written to the document yet
+    void copyJSON(rapidjson::Document &out) const;
+
     template <typename Type>
     std::optional<Type>
     unmarshal() const
     {
+        // A FlatStorage value might not have been written to the document yet
+        if (auto *slot = this->flatSlot.load(std::memory_order_acquire)) {
+            switch (slot->state.load(std::memory_order_acquire)) {
+                case detail::FlatSlot::State::Unset:
+                    return std::nullopt;
+
+                case detail::FlatSlot::State::Clean:
+                case detail::FlatSlot::State::Dirty: {
+                    auto value = detail::FlatStorage::toJSON(
+                        slot->kind, slot->bits.load(std::memory_order_relaxed));
+                    return Deserialize<Type>::get(value);
+                }
+
+                case detail::FlatSlot::State::Empty:
+                    break;
+            }
+        }
+
         auto *ptr = this->get();
 
         if (ptr == nullptr) {
@@ -81,12 +252,140 @@ public:
         return Deserialize<Type>::get(*ptr);
     }
 
+    /// The FlatStorage slot of this setting, acquiring one if needed
+    ///
+    /// Returns nullptr if the slot was acquired for a different kind of
+    /// value, e.g. by a Setting<double> while this is a Setting<int>
+    template <detail::IsFlatStorable Type>
+    detail::FlatSlot *
+    getFlatSlot()
+    {
+        return this->getFlatSlot(detail::flatKind<Type>());
+    }
+
+    template <detail::IsFlatStorable Type>
+    bool
+    marshalFlat(detail::FlatSlot &slot, Type v, SignalArgs args)
+    {
+        auto locked = this->instance.lock();
+        if (!locked) {
+            return false;
+        }
+
+        return locked->setFlat(*this, slot, detail::toFlatBits(v),
+                               std::move(args));
+    }
+
+    /// Read the value from `slot`
+    ///
+    /// Slots are kept up to date by whoever writes to the document, so this
+    /// never reads the document
+    template <detail::IsFlatStorable Type>
+    std::optional<Type>
+    unmarshalFlat(const detail::FlatSlot &slot) const
+    {
+        switch (slot.state.load(std::memory_order_acquire)) {
+            case detail::FlatSlot::State::Clean:
+            case detail::FlatSlot::State::Dirty:
+                return detail::fromFlatBits<Type>(
+                    slot.bits.load(std::memory_order_relaxed));
+
+            case detail::FlatSlot::State::Unset:
+            case detail::FlatSlot::State::Empty:
+                break;
+        }
+
+        return std::nullopt;
+    }
+
     int getUpdateIteration() const;
 
+    /// True once the SettingManager has been frozen, the value can't change anymore
+    bool isFrozen() const;
+
+    /// Number of listeners connected through `connect` that are still connected
+    std::size_t getListenerCount() const;
+
+    /// Number of Setting instances pointing at this data
+    std::size_t getHandleCount() const;
+
+    /// The live statistics of the SettingManager this setting belongs to
+    detail::ManagerStats &stats() const;
+
+    /// Add a coroutine waiter that's resumed on the next notifyUpdate
+    void addWaiter(detail::ChangeWaiter *waiter);
+
+    /// Remove a waiter that has not been resumed yet
+    void removeWaiter(detail::ChangeWaiter *waiter);
+
 private:
     friend class SettingManager;
+    friend class detail::SettingDataHandle;
 
     rapidjson::Value *get() const;
+
+    /// Point the setting at `newPath`, which its value has been moved to
+    void relocate(PathID newPath);
+
+    const rapidjson::Pointer &
+    getPointer() const
+    {
+        return *this->pointer.load(std::memory_order_acquire);
+    }
+
+    detail::FlatSlot *getFlatSlot(detail::FlatSlot::Kind kind);
+
+    void resumeWaiters(const rapidjson::Value &value, const SignalArgs &args);
+
+    /// Unlock `updateMutex` if it's held by this thread
+    void releaseUpdateLock();
+
+    std::mutex waitersMutex;
+    detail::ChangeWaiter *waiters = nullptr;
+
+    std::mutex updateMutex;
+    /// Thread holding `updateMutex`, only ever equal to the id of the thread
+    /// reading it if that thread holds it
+    std::atomic<std::thread::id> updateOwner;
 };
 
+namespace detail {
+
+/// A weak reference to a SettingData that counts towards its handle count
+///
+/// Entries with no handles & no listeners can be dropped by
+/// SettingManager::compactRegistry
+class SettingDataHandle
+{
+public:
+    /// Must be created while the SettingManager's settings mutex is held, or
+    /// from its frozen registry
+    explicit SettingDataHandle(const std::shared_ptr<SettingData> &_data);
+    SettingDataHandle(const SettingDataHandle &other);
+    SettingDataHandle &operator=(const SettingDataHandle &) = delete;
+    ~SettingDataHandle();
+
+    std::shared_ptr<SettingData>
+    lock() const
+    {
+        return this->data.lock();
+    }
+
+    bool
+    expired() const
+    {
+        return this->data.expired();
+    }
+
+    operator std::weak_ptr<SettingData>() const
+    {
+        return this->data;
+    }
+
+private:
+    std::weak_ptr<SettingData> data;
+};
+
+}  // namespace detail
+
 }  // namespace pajlada::Settings
@@ -6,13 +6,24 @@
 #include <atomic>
 #include <cinttypes>
 #include <filesystem>
+#include <functional>
+#include <future>
 #include <map>
 #include <memory>
 #include <mutex>
 #include <optional>
 #include <pajlada/settings/backup.hpp>
 #include <pajlada/settings/common.hpp>
+#include <pajlada/settings/detail/flatstorage.hpp>
+#include <pajlada/settings/detail/frozenregistry.hpp>
+#include <pajlada/settings/detail/memberindex.hpp>
+#include <pajlada/settings/key.hpp>
+#include <pajlada/settings/listenerprofiler.hpp>
+#include <pajlada/settings/memoryusage.hpp>
+#include <pajlada/settings/pathtable.hpp>
 #include <pajlada/settings/signalargs.hpp>
+#include <pajlada/settings/stats.hpp>
+#include <string_view>
 #include <vector>
 
 #include "pajlada/settings/loadoptions.hpp"
@@ -21,7 +32,13 @@ namespace pajlada::Settings {
 
 class SettingData;
 
-class SettingManager
+namespace detail {
+
+class SettingDataHandle;
+
+}  // namespace detail
+
+class SettingManager : public std::enable_shared_from_this<SettingManager>
 {
 public:
     SettingManager();
@@ -37,8 +54,17 @@ public:
 
         /// As part of loading the settings from the .tmp file using LoadOptions.attemptLoadFromTemporaryFile, we tried to save the now-loaded settings.json.tmp to settings.json, but it failed
         SavingFromTemporaryFileFailed,
+
+        /// The SettingManager was destroyed before an asynchronous load could finish
+        Cancelled,
+
+        /// The SettingManager has been frozen, see SettingManager::freeze
+        Frozen,
     };
 
+    /// Runs the given task, e.g. by posting it to an event loop
+    using Executor = std::function<void(std::function<void()>)>;
+
     enum class SaveResult : std::uint8_t {
         /// Saving the settings to a file failed
         /// We currently don't elaborate why it failed
@@ -51,14 +77,93 @@ public:
         Skipped,
     };
 
+    /// Values of FlatStorage settings show up here once they've been
+    /// flushed, see flushFlatStorage
     rapidjson::Value *get(const std::string &path);
     bool set(const std::string &path, const rapidjson::Value &value,
              SignalArgs args = SignalArgs());
 
+    /// Look up the values at many paths at once
+    ///
+    /// Each path only walks the tokens it doesn't share with the previous
+    /// one, so sorted paths resolve their common parents a single time.
+    /// Entries are nullptr for values that don't exist.
+    std::vector<rapidjson::Value *> getMany(
+        const std::vector<std::string> &paths);
+    std::vector<rapidjson::Value *> getMany(const std::vector<PathID> &paths);
+
+    /// Set many values at once, like calling `set` for each of them
+    ///
+    /// The registry is locked once, common parents of sorted paths are
+    /// walked once, and listeners are notified after all values have been
+    /// written. The notifications form one batch, which a
+    /// CoalescingSettingListener delivers as a single callback.
+    ///
+    /// Returns the number of values that were set
+    std::size_t setMany(
+        const std::vector<std::pair<std::string, rapidjson::Value>> &values,
+        SignalArgs args = SignalArgs());
+    std::size_t setMany(
+        const std::vector<std::pair<PathID, rapidjson::Value>> &values,
+        SignalArgs args = SignalArgs());
+
+    /// Update iteration of the setting at `path`, which goes up with every
+    /// change of its value
+    ///
+    /// Returns -1 if no setting is registered at `path`
+    int getVersion(const std::string &path);
+
+    /// Set `value` at `path` if the setting's update iteration is still
+    /// `expectedIteration`, as returned by getVersion before reading the value
+    ///
+    /// The check & the write run under the same lock as Setting::update, so
+    /// of several writers expecting the same iteration only one succeeds, the
+    /// others can read the value again & retry. Plain `set` calls don't take
+    /// that lock.
+    ///
+    /// Returns false if the iteration didn't match, no setting is registered
+    /// at `path` or the value couldn't be set
+    bool setIfVersion(const std::string &path, const rapidjson::Value &value,
+                      int expectedIteration, SignalArgs args = SignalArgs());
+
 private:
+    template <typename Paths>
+    std::vector<rapidjson::Value *> getManyImpl(const Paths &paths);
+
+    template <typename Values>
+    std::size_t setManyImpl(const Values &values, SignalArgs args);
+
+    rapidjson::Value *get(const rapidjson::Pointer &pointer);
+
+    /// Set through a SettingData's cached pointer, skipping the path lookup
+    bool set(SettingData &setting, const rapidjson::Value &value,
+             SignalArgs args);
+
+    /// `setting` is the SettingData at `path`, or nullptr if there's none
+    bool setImpl(const std::string &path, const rapidjson::Pointer &pointer,
+                 SettingData *setting, const rapidjson::Value &value,
+                 SignalArgs args);
+
+    /// Set through the FlatStorage slot of `setting`, leaving the document as is
+    bool setFlat(SettingData &setting, detail::FlatSlot &slot,
+                 std::uint64_t bits, SignalArgs args);
+
+    /// Add or assign the member `key` of the object at `setting`, leaving
+    /// the other members as they are
+    bool setMember(SettingData &setting, std::string_view key,
+                   const rapidjson::Value &value, SignalArgs args);
+
+    /// Remove the member `key` from the object at `setting`
+    ///
+    /// The last member is moved into its place
+    bool eraseMember(SettingData &setting, std::string_view key,
+                     SignalArgs args);
+
     // Called from set
     void notifyUpdate(const std::string &path, const rapidjson::Value &value,
                       SignalArgs args = SignalArgs());
+    void notifyUpdate(SettingData &setting, const rapidjson::Value &value,
+                      SignalArgs args);
 
     // Called from load
     void notifyLoadedValues();
@@ -83,8 +188,57 @@ public:
     static bool removeArrayValue(const std::string &arrayPath,
                                  rapidjson::SizeType index);
 
+    /// Calls removeArrayValue for every null value after the first element of
+    /// the array at the given path, so only trailing nulls are removed
+    ///
+    /// Uses the global instance. Prefer compactArray, which removes every
+    /// null in a single pass & moves the following elements down
     static rapidjson::SizeType cleanArray(const std::string &arrayPath);
 
+    /// Remove every element of the array at the given path that matches
+    /// `predicate`, keeping the order of the other elements
+    ///
+    /// Runs in a single pass over the array & the settings registered inside
+    /// it. Settings inside a removed element are invalidated, settings inside
+    /// a moved element follow it to its new index. A setting registered at
+    /// the array itself is notified.
+    ///
+    /// Returns the number of elements that were removed
+    rapidjson::SizeType compactArray(
+        const std::string &arrayPath,
+        const std::function<bool(const rapidjson::Value &)> &predicate);
+
+    /// Insert `value` into the array at the given path before `index`
+    ///
+    /// `index` may be the size of the array to append the value. Like
+    /// compactArray, settings inside the elements after `index` follow their
+    /// element to its new index. A setting registered at the array itself is
+    /// notified.
+    ///
+    /// Returns false if there's no array at the path or `index` is out of bounds
+    bool insertArrayValue(const std::string &arrayPath,
+                          rapidjson::SizeType index,
+                          const rapidjson::Value &value);
+
+    /// Remove the element at `index` from the array at the given path
+    ///
+    /// Unlike removeArrayValue, the following elements are moved down &
+    /// their settings follow them. Settings inside the removed element are
+    /// invalidated.
+    ///
+    /// Returns false if there's no array at the path or `index` is out of bounds
+    bool eraseArrayValue(const std::string &arrayPath,
+                         rapidjson::SizeType index);
+
+    /// Move the element at `from` to `to` in the array at the given path,
+    /// shifting the elements in between by one
+    ///
+    /// Settings inside the moved elements follow them.
+    ///
+    /// Returns false if there's no array at the path or an index is out of bounds
+    bool moveArrayValue(const std::string &arrayPath, rapidjson::SizeType from,
+                        rapidjson::SizeType to);
+
     // Useful object helper methods
     /// Return a list of keys of the object at the given path
     ///
@@ -97,11 +251,43 @@ public:
         const std::string &objectPath,
         std::shared_ptr<SettingManager> instance);
 
+    /// Call `callback` with every key of the object at the given path, in order
+    ///
+    /// The keys point into the document and are only valid during the call,
+    /// nothing is copied. The callback must not change the object.
+    ///
+    /// Returns false if there's no object at the path
+    bool forEachObjectKey(const std::string &objectPath,
+                          const std::function<void(std::string_view)> &callback);
+
+    /// Like forEachObjectKey, but also passes the value of every member
+    bool forEachObjectMember(
+        const std::string &objectPath,
+        const std::function<void(std::string_view, const rapidjson::Value &)>
+            &callback);
+
     static void clear();
 
     static std::weak_ptr<SettingData> getSetting(
         const std::string &path, std::shared_ptr<SettingManager> instance);
 
+    /// Like getSetting, but the returned handle keeps the entry from being
+    /// dropped by compactRegistry
+    static detail::SettingDataHandle getSettingHandle(
+        const std::string &path, std::shared_ptr<SettingManager> instance);
+
+    /// Drop registry entries that no Setting, listener or awaiter uses anymore
+    ///
+    /// Values in the document are kept, a new Setting at the same path
+    /// creates a new entry.
+    ///
+    /// If `budget` is non-zero, at most `budget` entries are inspected,
+    /// continuing where the previous call stopped. This allows compacting
+    /// a large registry a bit at a time, e.g. from an idle timer.
+    ///
+    /// Returns the number of entries that were dropped
+    std::size_t compactRegistry(std::size_t budget = 0);
+
     /// Invalidate the setting and all other settings that point at the same path
     /// If the setting is an object or array, any child settings will also be invalidated
     ///
@@ -123,11 +309,55 @@ public:
 private:
     template <typename Type>
     friend class Setting;
+    template <typename Type>
+    friend class AtomicSetting;
+    friend class SettingData;
 
     bool _removeSetting(const std::string &path);
 
+    /// Like getSetting, but takes an interned path
+    static detail::SettingDataHandle getSettingHandle(
+        PathID path, std::shared_ptr<SettingManager> instance);
+
+    /// Like getSettingHandle, but goes through the manager's key table after the first call
+    static detail::SettingDataHandle getSettingHandle(
+        const detail::KeyBinding &key,
+        std::shared_ptr<SettingManager> instance);
+
     void clearSettings(const std::string &root);
 
+    /// Move the settings registered inside the array at `arrayPath` to the
+    /// new index of their element, after the array has been rearranged
+    ///
+    /// `newIndices[i]` is the new index of element `i`, or
+    /// rapidjson::kPointerInvalidIndex if it was removed. Settings inside a
+    /// removed element are dropped from the registry.
+    ///
+    /// Returns the setting registered at the array itself, if any
+    std::shared_ptr<SettingData> remapArrayElements(
+        const std::string &arrayPath,
+        const std::vector<rapidjson::SizeType> &newIndices);
+
+    /// Remap the settings inside `array` after its elements have been
+    /// rearranged, save & notify the setting at the array
+    ///
+    /// `newIndices` is empty if no element moved
+    void arrayElementsMoved(const std::string &arrayPath,
+                            const rapidjson::Value &array,
+                            const std::vector<rapidjson::SizeType> &newIndices,
+                            SignalArgs args);
+
+    /// insertArrayValue through a SettingData's cached pointer
+    bool insertArrayValue(const std::string &arrayPath,
+                          const rapidjson::Pointer &arrayPointer,
+                          rapidjson::SizeType index,
+                          const rapidjson::Value &value, SignalArgs args);
+
+    /// eraseArrayValue through a SettingData's cached pointer
+    bool eraseArrayValue(const std::string &arrayPath,
+                         const rapidjson::Pointer &arrayPointer,
+                         rapidjson::SizeType index, SignalArgs args);
+
 public:
     void setPath(const std::filesystem::path &newPath);
 
@@ -143,6 +373,32 @@ public:
     LoadError loadFrom(const std::filesystem::path &path,
                        std::optional<LoadOptions> overrideLoadOptions = {});
 
+    /// Load from given path and set given path as the "default path" (or load
+    /// from default path if the path is empty) without blocking the caller.
+    ///
+    /// The file is read & parsed into a separate document on a worker thread.
+    /// The new document is then swapped in and the loaded values are notified
+    /// from a task given to `executor`, which must run it on the thread that
+    /// uses the SettingManager. The returned future completes after that.
+    ///
+    /// If no executor is given, the task is queued on the SettingManager and
+    /// run by the next call to `applyPendingLoads`. Don't block on the future
+    /// before that, poll it with `wait_for` instead.
+    ///
+    /// The SettingManager must be owned by a std::shared_ptr, this is asserted.
+    /// If it has been destroyed by the time the task runs, the load fails with
+    /// `Cancelled`.
+    std::future<LoadError> loadAsync(
+        const std::filesystem::path &path = {}, Executor executor = {},
+        std::optional<LoadOptions> overrideLoadOptions = {});
+
+    /// Swaps in the documents parsed by `loadAsync` calls made without an
+    /// executor & completes their futures. Must be called from the thread that
+    /// uses the SettingManager.
+    ///
+    /// Returns the number of loads that were applied
+    std::size_t applyPendingLoads();
+
     static SaveResult gSave(const std::filesystem::path &path = {});
     static SaveResult gSaveAs(const std::filesystem::path &path);
 
@@ -155,11 +411,58 @@ public:
     // Save to given path
     SaveResult saveAs(const std::filesystem::path &path);
 
+    /// Write the values of settings using SettingOption::FlatStorage into `document`
+    ///
+    /// This happens automatically before saving & freezing. Until then,
+    /// those values are only seen through the settings at their paths, not
+    /// through `get`, `getMany` or `document`.
+    /// Like any other write, don't call this while other threads read the
+    /// document.
+    ///
+    /// Returns the number of values written
+    std::size_t flushFlatStorage();
+
+    /// Index the members of objects with at least `threshold` members
+    ///
+    /// Reads & writes through the SettingManager look members of those
+    /// objects up through a hash table instead of rapidjson's linear scan.
+    /// The table of an object is built on the first lookup in it, extended
+    /// when members are added through the SettingManager and dropped when
+    /// values are removed.
+    /// Call `invalidateDocumentCaches` after changing `document` directly.
+    ///
+    /// 0 (the default) disables the index
+    void setMemberIndexThreshold(std::size_t threshold);
+
+    /// Read the FlatStorage values from the document again & drop the member indexes
+    ///
+    /// Only needed after changing `document` directly
+    void invalidateDocumentCaches();
+
 private:
+    /// Drop the member indexes & read the FlatStorage values at, inside or
+    /// above `changed` from the document again
+    void invalidateDocumentCaches(const rapidjson::Pointer &changed);
+
     bool writeTo(const std::filesystem::path &path);
 
+    LoadError loadFromImpl(const std::filesystem::path &path,
+                           std::optional<LoadOptions> overrideLoadOptions);
+
     LoadError readFrom(const std::filesystem::path &_path);
 
+    /// Read & parse the file at the given path into `parsed`
+    /// If the file is empty, `parsed` is left as a null value
+    static LoadError parseFile(const std::filesystem::path &_path,
+                               rapidjson::Document &parsed);
+
+    /// Swap in a document read by parseFile & notify all settings of their new values
+    void applyParsedDocument(rapidjson::Document &parsed);
+
+    /// Write the settings loaded from `tmpPath` to `path` & remove the temporary file
+    LoadError finishLoadFromTemporaryFile(const std::filesystem::path &path,
+                                          const std::filesystem::path &tmpPath);
+
 public:
     // Functions prefixed with g are static functions that work
     // on the statically initialized SettingManager instance
@@ -201,21 +504,96 @@ public:
     void setBackupEnabled(bool enabled = true);
     void setBackupSlots(uint8_t numSlots);
 
+    /// Returns a snapshot of this manager's runtime statistics
+    ///
+    /// All values are zero if the library was built without PAJLADA_SETTINGS_STATS
+    Stats stats() const;
+
+    /// Opt-in timing of the listeners of this manager's settings
+    ListenerProfiler &listenerProfiler();
+
+    /// Make the document & the setting registry read-only
+    ///
+    /// Afterwards, every write (set, remove, clear, load) is rejected: setters
+    /// return false & loads return LoadError::Frozen. In exchange, nothing
+    /// needs to lock anymore:
+    ///  - Settings registered before freezing are found through a perfect
+    ///    hash table instead of the locked registry
+    ///  - Setting::getValue only locks on its first call
+    ///
+    /// Settings at paths that were not registered before freezing are
+    /// invalid, they read their default value. `get` still reads any path.
+    /// Saving is still possible. A frozen manager can't be unfrozen.
+    void freeze();
+
+    bool isFrozen() const;
+
+    /// Report the memory used by the document & the setting registry
+    ///
+    /// Walks the whole document, so this is not meant to be called often
+    MemoryUsage memoryUsage();
+
     static const std::shared_ptr<SettingManager> &getInstance();
 
 private:
     std::shared_ptr<SettingData> getSetting(const std::string &path);
 
+    /// Must be called with settingsMutex held, `self` must point at this manager
+    /// If the setting is created, it uses `pointer` instead of parsing the path
+    const std::shared_ptr<SettingData> &findOrCreateSetting(
+        PathID path, const std::shared_ptr<SettingManager> &self,
+        const rapidjson::Pointer *pointer = nullptr);
+
 public:
     rapidjson::Document document;
 
 private:
     std::filesystem::path filePath = "settings.json";
 
+    /// Shared with our SettingData so reads through Setting can be counted
+    const std::shared_ptr<detail::ManagerStats> statistics;
+
+    /// Shared with our SettingData, which time their listeners through it
+    const std::shared_ptr<ListenerProfiler> profiler;
+
+    /// Shared with our SettingData, which keep their FlatStorage slots in it
+    const std::shared_ptr<detail::FlatStorage> flatStorage;
+
+    /// Tasks queued by loadAsync calls made without an executor
+    struct PendingLoads {
+        std::mutex mutex;
+        std::vector<std::function<void()>> tasks;
+
+        /// Set when the SettingManager is destroyed, tasks queued after that
+        /// are run right away & fail with `Cancelled`
+        bool closed = false;
+    };
+
+    /// Shared with the loadAsync worker threads
+    const std::shared_ptr<PendingLoads> pendingLoads;
+
+    /// Set by freeze, shared with our SettingData
+    const std::shared_ptr<std::atomic<bool>> frozen;
+
+    /// Built by freeze from `settings`, never changes afterwards
+    detail::FrozenRegistry frozenRegistry;
+
+    /// Member lookups in large objects of `document`
+    detail::MemberIndex memberIndex;
+
     std::mutex settingsMutex;
 
-    //       path         setting
-    std::map<std::string, std::shared_ptr<SettingData>> settings;
+    /// Keys point at the interned path of the SettingData
+    //       path              setting
+    std::map<std::string_view, std::shared_ptr<SettingData>, std::less<>>
+        settings;
+
+    /// Where the next budgeted compactRegistry continues
+    std::string compactCursor;
+
+    /// Settings bound to a Key, indexed by the key's slot
+    /// Guarded by settingsMutex. Entries expire when the registry drops the setting.
+    std::vector<std::weak_ptr<SettingData>> keySlots;
 };
 
 }  // namespace pajlada::Settings
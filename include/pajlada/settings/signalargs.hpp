@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstddef>
+#include <pajlada/settings/pathtable.hpp>
 #include <string>
 
 namespace pajlada::Settings {
@@ -17,6 +19,30 @@ struct SignalArgs {
 
     std::string path;
 
+    /// Path of the setting that changed, filled in by the SettingManager
+    /// Empty for OnConnect notifications
+    PathID pathID;
+
+    enum class Change {
+        /// The whole value was set
+        Value,
+        /// The member `key` of the object was added or assigned
+        MemberAssigned,
+        /// The member `key` was removed from the object
+        MemberErased,
+        /// An element was inserted into the array at `index`
+        ElementInserted,
+        /// The element at `index` was removed from the array
+        ElementErased,
+    } change = Change::Value;
+
+    /// Key of the changed member for MemberAssigned & MemberErased
+    /// Listeners can read just that member from the notified object
+    std::string key;
+
+    /// Index of the changed element for ElementInserted & ElementErased
+    std::size_t index{};
+
     bool writeToFile{true};
     bool compareBeforeSet{false};
 
@@ -30,6 +56,9 @@ private:
 
     template <typename Type>
     friend class Setting;
+
+    template <typename Type>
+    friend class AtomicSetting;
 };
 
 }  // namespace pajlada::Settings
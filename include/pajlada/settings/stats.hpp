@@ -0,0 +1,215 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace pajlada::Settings {
+
+/// Latency histogram with power-of-two microsecond buckets
+///
+/// Bucket 0 counts samples below 1 microsecond, bucket `i` counts samples in
+/// [2^(i-1), 2^i) microseconds. The last bucket also counts everything above it.
+struct LatencyHistogram {
+    static constexpr std::size_t NUM_BUCKETS = 24;
+
+    std::array<std::uint64_t, NUM_BUCKETS> buckets{};
+    std::uint64_t count = 0;
+    std::chrono::nanoseconds total{};
+    std::chrono::nanoseconds max{};
+};
+
+/// A snapshot of the runtime statistics of a SettingManager
+///
+/// All values are zero if the library was built without PAJLADA_SETTINGS_STATS
+struct Stats {
+    /// Number of reads through Setting (getValue, hasValueBeenSet, ...)
+    std::uint64_t getCalls = 0;
+
+    /// Number of calls to SettingManager::set (i.e. all writes)
+    std::uint64_t setCalls = 0;
+
+    /// Number of JSON pointers resolved against the document
+    std::uint64_t pointerResolutions = 0;
+
+    /// Number of times a setting's listeners were notified
+    std::uint64_t notificationsFired = 0;
+
+    std::uint64_t savesAttempted = 0;
+    /// Saves skipped because of SaveMethod::OnlySaveIfChanged
+    std::uint64_t savesSkipped = 0;
+    std::uint64_t savesFailed = 0;
+    std::uint64_t bytesWritten = 0;
+
+    /// Time spent in the listeners of a single notification
+    LatencyHistogram listenerTime;
+    LatencyHistogram saveDuration;
+    LatencyHistogram loadDuration;
+    /// Time spent shifting & renaming files in Backup::saveWithBackup
+    LatencyHistogram backupRotationTime;
+};
+
+namespace detail {
+
+#ifdef PAJLADA_SETTINGS_STATS
+
+class StatCounter
+{
+    std::atomic<std::uint64_t> value{};
+
+public:
+    void
+    add(std::uint64_t n = 1)
+    {
+        this->value.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    std::uint64_t
+    load() const
+    {
+        return this->value.load(std::memory_order_relaxed);
+    }
+};
+
+class StatHistogram
+{
+    std::array<std::atomic<std::uint64_t>, LatencyHistogram::NUM_BUCKETS>
+        buckets{};
+    std::atomic<std::uint64_t> count{};
+    std::atomic<std::uint64_t> totalNs{};
+    std::atomic<std::uint64_t> maxNs{};
+
+public:
+    void
+    record(std::chrono::nanoseconds duration)
+    {
+        auto ns = static_cast<std::uint64_t>(duration.count());
+        auto bucket = std::min<std::size_t>(std::bit_width(ns / 1000),
+                                            LatencyHistogram::NUM_BUCKETS - 1);
+
+        this->buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+        this->count.fetch_add(1, std::memory_order_relaxed);
+        this->totalNs.fetch_add(ns, std::memory_order_relaxed);
+
+        auto prevMax = this->maxNs.load(std::memory_order_relaxed);
+        while (prevMax < ns && !this->maxNs.compare_exchange_weak(
+                                   prevMax, ns, std::memory_order_relaxed)) {
+        }
+    }
+
+    LatencyHistogram
+    load() const
+    {
+        LatencyHistogram h;
+        for (std::size_t i = 0; i < h.buckets.size(); ++i) {
+            h.buckets[i] = this->buckets[i].load(std::memory_order_relaxed);
+        }
+        h.count = this->count.load(std::memory_order_relaxed);
+        h.total = std::chrono::nanoseconds(
+            this->totalNs.load(std::memory_order_relaxed));
+        h.max = std::chrono::nanoseconds(
+            this->maxNs.load(std::memory_order_relaxed));
+        return h;
+    }
+};
+
+class StatTimer
+{
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+
+public:
+    std::chrono::nanoseconds
+    elapsed() const
+    {
+        return std::chrono::steady_clock::now() - this->start;
+    }
+};
+
+#else
+
+class StatCounter
+{
+public:
+    void
+    add(std::uint64_t /*n*/ = 1)
+    {
+    }
+
+    std::uint64_t
+    load() const
+    {
+        return 0;
+    }
+};
+
+class StatHistogram
+{
+public:
+    void
+    record(std::chrono::nanoseconds /*duration*/)
+    {
+    }
+
+    LatencyHistogram
+    load() const
+    {
+        return {};
+    }
+};
+
+class StatTimer
+{
+public:
+    std::chrono::nanoseconds
+    elapsed() const
+    {
+        return {};
+    }
+};
+
+#endif
+
+/// The live counters behind SettingManager::stats
+struct ManagerStats {
+    StatCounter getCalls;
+    StatCounter setCalls;
+    StatCounter pointerResolutions;
+    StatCounter notificationsFired;
+    StatCounter savesAttempted;
+    StatCounter savesSkipped;
+    StatCounter savesFailed;
+    StatCounter bytesWritten;
+
+    StatHistogram listenerTime;
+    StatHistogram saveDuration;
+    StatHistogram loadDuration;
+    StatHistogram backupRotationTime;
+
+    Stats
+    snapshot() const
+    {
+        Stats s;
+        s.getCalls = this->getCalls.load();
+        s.setCalls = this->setCalls.load();
+        s.pointerResolutions = this->pointerResolutions.load();
+        s.notificationsFired = this->notificationsFired.load();
+        s.savesAttempted = this->savesAttempted.load();
+        s.savesSkipped = this->savesSkipped.load();
+        s.savesFailed = this->savesFailed.load();
+        s.bytesWritten = this->bytesWritten.load();
+        s.listenerTime = this->listenerTime.load();
+        s.saveDuration = this->saveDuration.load();
+        s.loadDuration = this->loadDuration.load();
+        s.backupRotationTime = this->backupRotationTime.load();
+        return s;
+    }
+};
+
+}  // namespace detail
+
+}  // namespace pajlada::Settings
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+
+namespace pajlada::Settings::Trace {
+
+struct Event {
+    enum class Type {
+        /// A scoped span with a duration
+        Span,
+        /// A single point in time (e.g. a debug message)
+        Instant,
+    } type = Type::Span;
+
+    /// Must point at a string literal
+    std::string_view name;
+    /// Must point at a string literal
+    std::string_view category;
+
+    std::chrono::steady_clock::time_point start;
+    std::chrono::nanoseconds duration{};
+    std::thread::id thread;
+
+    /// Free-form detail, e.g. the setting path or the debug message
+    std::string detail;
+
+    /// Optional count attached to the span (e.g. number of listeners connected)
+    /// Negative if unset
+    std::int64_t count = -1;
+};
+
+/// Receives trace events
+///
+/// `write` may be called from any thread the library does work on
+class Sink
+{
+public:
+    virtual ~Sink() = default;
+
+    virtual void write(const Event &event) = 0;
+};
+
+/// Set the global trace sink, or disable tracing by passing nullptr
+void setSink(std::shared_ptr<Sink> sink);
+
+std::shared_ptr<Sink> getSink();
+
+namespace detail {
+
+extern std::atomic<bool> enabled;
+
+}  // namespace detail
+
+/// Returns true if a sink is set
+inline bool
+isEnabled()
+{
+    return detail::enabled.load(std::memory_order_relaxed);
+}
+
+/// Emit an instant event if tracing is enabled
+void instant(std::string_view name, std::string detail,
+             std::string_view category = "settings");
+
+/// Scoped span, written to the sink when it goes out of scope
+///
+/// If no sink is set when the span is created, the span does nothing
+class Span
+{
+public:
+    explicit Span(std::string_view name,
+                  std::string_view category = "settings");
+    ~Span();
+
+    Span(const Span &) = delete;
+    Span &operator=(const Span &) = delete;
+    Span(Span &&) = delete;
+    Span &operator=(Span &&) = delete;
+
+    /// Returns true if this span will be written to a sink
+    bool
+    active() const
+    {
+        return this->sink != nullptr;
+    }
+
+    void
+    setDetail(std::string_view detail)
+    {
+        if (this->active()) {
+            this->event.detail = detail;
+        }
+    }
+
+    void
+    setCount(std::int64_t count)
+    {
+        this->event.count = count;
+    }
+
+private:
+    std::shared_ptr<Sink> sink;
+    Event event;
+};
+
+/// Writes events in the Chrome trace event format (JSON array)
+///
+/// The resulting file can be opened in chrome://tracing or ui.perfetto.dev.
+/// Timestamps are relative to the creation of the sink.
+class ChromeTraceSink : public Sink
+{
+public:
+    explicit ChromeTraceSink(const std::filesystem::path &path);
+    ~ChromeTraceSink() override;
+
+    /// Returns false if the trace file could not be opened
+    bool isOpen() const;
+
+    void write(const Event &event) override;
+
+    /// Flush written events to disk
+    void flush();
+
+private:
+    std::mutex mutex;
+    std::ofstream fh;
+    const std::chrono::steady_clock::time_point epoch;
+    bool first = true;
+};
+
+}  // namespace pajlada::Settings::Trace
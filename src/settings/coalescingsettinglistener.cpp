@@ -0,0 +1,243 @@
+#include <algorithm>
+#include <pajlada/settings/coalescingsettinglistener.hpp>
+#include <pajlada/settings/detail/notificationbatch.hpp>
+#include <utility>
+
+namespace pajlada {
+
+CoalescingSettingListener::Transaction::Transaction(
+    CoalescingSettingListener &_listener)
+    : listener(&_listener)
+{
+    this->listener->beginTransaction();
+}
+
+CoalescingSettingListener::Transaction::~Transaction()
+{
+    if (this->listener != nullptr) {
+        this->listener->endTransaction();
+    }
+}
+
+CoalescingSettingListener::Transaction::Transaction(
+    Transaction &&other) noexcept
+    : listener(std::exchange(other.listener, nullptr))
+{
+}
+
+CoalescingSettingListener::CoalescingSettingListener(
+    Callback callback, std::chrono::milliseconds _window)
+    : cb(std::move(callback))
+    , window(_window)
+{
+    if (this->window > std::chrono::milliseconds::zero()) {
+        this->timer = std::thread([this] {
+            this->runTimer();  //
+        });
+    }
+}
+
+CoalescingSettingListener::~CoalescingSettingListener()
+{
+    // Disconnect first so no new changes come in while we're shutting down
+    this->managedConnections.clear();
+
+    {
+        // Pending batch callbacks must not use us once we're gone
+        std::unique_lock<std::mutex> lock(this->lifetime->mutex);
+        this->lifetime->alive = false;
+        this->lifetime->released.wait(lock, [this] {
+            return this->lifetime->users == 0;
+        });
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(this->stateMutex);
+        this->stopping = true;
+    }
+    this->stateChanged.notify_all();
+
+    if (this->timer.joinable()) {
+        this->timer.join();
+    }
+
+    this->resetCB();
+}
+
+void
+CoalescingSettingListener::setCB(Callback callback)
+{
+    std::unique_lock<std::mutex> lock(this->cbMutex);
+    this->cb = std::move(callback);
+}
+
+void
+CoalescingSettingListener::resetCB()
+{
+    std::unique_lock<std::mutex> lock(this->cbMutex);
+    this->cb = Callback();
+}
+
+void
+CoalescingSettingListener::markChanged(const std::string &path)
+{
+    {
+        std::unique_lock<std::mutex> lock(this->stateMutex);
+
+        if (std::find(this->pending.begin(), this->pending.end(), path) ==
+            this->pending.end()) {
+            this->pending.push_back(path);
+        }
+
+        using Settings::detail::NotificationBatch;
+        if (NotificationBatch::isOpen() && !this->batchPending) {
+            // Deliver once every setting of the batch has been notified
+            this->batchPending = true;
+            ++this->transactionDepth;
+            NotificationBatch::onEnd([this, lifetime = this->lifetime] {
+                {
+                    std::unique_lock<std::mutex> lock(lifetime->mutex);
+                    if (!lifetime->alive) {
+                        return;
+                    }
+                    // Keeps the destructor waiting until we're done
+                    ++lifetime->users;
+                }
+
+                {
+                    std::unique_lock<std::mutex> lock(this->stateMutex);
+                    this->batchPending = false;
+                }
+                this->endTransaction();
+
+                std::unique_lock<std::mutex> lock(lifetime->mutex);
+                --lifetime->users;
+                lifetime->released.notify_all();
+            });
+            return;
+        }
+
+        if (this->transactionDepth > 0) {
+            // The batch will be delivered when the transaction ends
+            return;
+        }
+
+        if (this->window > std::chrono::milliseconds::zero()) {
+            if (!this->deadline) {
+                this->deadline =
+                    std::chrono::steady_clock::now() + this->window;
+                this->stateChanged.notify_all();
+            }
+            return;
+        }
+    }
+
+    this->flush();
+}
+
+void
+CoalescingSettingListener::flush()
+{
+    {
+        std::unique_lock<std::mutex> lock(this->stateMutex);
+        if (this->flushing &&
+            this->flushingThread == std::this_thread::get_id()) {
+            // Called from within the callback, the loop below picks up
+            // whatever we've added once the callback returns
+            return;
+        }
+
+        // Another thread may be in the middle of a callback, wait for it so
+        // our changes have been delivered when we return
+        this->flushDone.wait(lock, [this] {
+            return !this->flushing;
+        });
+
+        this->flushing = true;
+        this->flushingThread = std::this_thread::get_id();
+    }
+
+    while (true) {
+        std::vector<std::string> batch;
+
+        {
+            std::unique_lock<std::mutex> lock(this->stateMutex);
+            this->deadline.reset();
+            if (this->pending.empty()) {
+                this->flushing = false;
+                this->flushDone.notify_all();
+                return;
+            }
+            batch.swap(this->pending);
+        }
+
+        // Changes made from within the callback end up in the next batch
+        std::unique_lock<std::mutex> lock(this->cbMutex);
+        if (this->cb) {
+            this->cb(batch);
+        }
+    }
+}
+
+CoalescingSettingListener::Transaction
+CoalescingSettingListener::transaction()
+{
+    return Transaction(*this);
+}
+
+void
+CoalescingSettingListener::beginTransaction()
+{
+    std::unique_lock<std::mutex> lock(this->stateMutex);
+    ++this->transactionDepth;
+}
+
+void
+CoalescingSettingListener::endTransaction()
+{
+    {
+        std::unique_lock<std::mutex> lock(this->stateMutex);
+        if (--this->transactionDepth > 0) {
+            return;
+        }
+    }
+
+    this->flush();
+}
+
+void
+CoalescingSettingListener::runTimer()
+{
+    std::unique_lock<std::mutex> lock(this->stateMutex);
+
+    while (!this->stopping) {
+        if (!this->deadline) {
+            this->stateChanged.wait(lock);
+            continue;
+        }
+
+        auto until = *this->deadline;
+        if (this->stateChanged.wait_until(lock, until) ==
+            std::cv_status::no_timeout) {
+            // Woken up early, re-evaluate the deadline
+            continue;
+        }
+
+        if (this->stopping || !this->deadline ||
+            std::chrono::steady_clock::now() < *this->deadline) {
+            continue;
+        }
+
+        if (this->transactionDepth > 0) {
+            // The batch will be delivered when the transaction ends
+            this->deadline.reset();
+            continue;
+        }
+
+        lock.unlock();
+        this->flush();
+        lock.lock();
+    }
+}
+
+}  // namespace pajlada
@@ -0,0 +1,305 @@
+#include <algorithm>
+#include <cstring>
+#include <string_view>
+#include <pajlada/settings/detail/flatstorage.hpp>
+
+namespace pajlada::Settings::detail {
+
+namespace {
+
+/// True if the tokens of the shorter pointer are a prefix of the longer one
+bool
+overlaps(const rapidjson::Pointer &a, const rapidjson::Pointer &b)
+{
+    const auto count = std::min(a.GetTokenCount(), b.GetTokenCount());
+
+    for (std::size_t i = 0; i < count; ++i) {
+        const auto &lhs = a.GetTokens()[i];
+        const auto &rhs = b.GetTokens()[i];
+        if (lhs.length != rhs.length ||
+            std::memcmp(lhs.name, rhs.name, lhs.length) != 0) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/// True if `pointer` is `inside` or one of its descendants
+bool
+isInside(const rapidjson::Pointer &pointer, const rapidjson::Pointer &inside)
+{
+    return pointer.GetTokenCount() >= inside.GetTokenCount() &&
+           overlaps(pointer, inside);
+}
+
+/// Append the key of `token` to `key`
+///
+/// Tokens are prefixed with their length, so no token's key is a prefix of
+/// another's & keys only share prefixes along whole tokens
+void
+appendTokenKey(std::string &key, const rapidjson::Pointer::Token &token)
+{
+    key += std::to_string(token.length);
+    key += ':';
+    key.append(token.name, token.length);
+}
+
+std::string
+pathKey(const rapidjson::Pointer &pointer)
+{
+    std::string key;
+    for (std::size_t i = 0; i < pointer.GetTokenCount(); ++i) {
+        appendTokenKey(key, pointer.GetTokens()[i]);
+    }
+
+    return key;
+}
+
+}  // namespace
+
+rapidjson::Value
+FlatStorage::toJSON(FlatSlot::Kind kind, std::uint64_t bits)
+{
+    switch (kind) {
+        case FlatSlot::Kind::Bool:
+            return rapidjson::Value(bits != 0);
+        case FlatSlot::Kind::Int:
+            return rapidjson::Value(static_cast<std::int64_t>(bits));
+        case FlatSlot::Kind::Uint:
+            return rapidjson::Value(bits);
+        case FlatSlot::Kind::Double:
+            return rapidjson::Value(std::bit_cast<double>(bits));
+    }
+
+    return {};
+}
+
+std::uint64_t
+FlatStorage::fromJSON(FlatSlot::Kind kind, const rapidjson::Value &value)
+{
+    switch (kind) {
+        case FlatSlot::Kind::Bool:
+            if (value.IsBool()) {
+                return value.GetBool() ? 1 : 0;
+            }
+            if (value.IsInt()) {
+                return value.GetInt() == 1 ? 1 : 0;
+            }
+            return 0;
+
+        case FlatSlot::Kind::Int:
+            if (value.IsInt64()) {
+                return toFlatBits(value.GetInt64());
+            }
+            if (value.IsNumber()) {
+                return toFlatBits(static_cast<std::int64_t>(value.GetDouble()));
+            }
+            return 0;
+
+        case FlatSlot::Kind::Uint:
+            if (value.IsUint64()) {
+                return toFlatBits(value.GetUint64());
+            }
+            if (value.IsInt64()) {
+                return toFlatBits(static_cast<std::uint64_t>(value.GetInt64()));
+            }
+            if (value.IsNumber()) {
+                return toFlatBits(static_cast<std::uint64_t>(value.GetDouble()));
+            }
+            return 0;
+
+        case FlatSlot::Kind::Double:
+            if (value.IsNumber()) {
+                return toFlatBits(value.GetDouble());
+            }
+            return toFlatBits(0.0);
+    }
+
+    return 0;
+}
+
+FlatSlot *
+FlatStorage::acquire(FlatSlot::Kind kind, const rapidjson::Pointer *pointer,
+                     const rapidjson::Value &document)
+{
+    std::lock_guard lock(this->mutex);
+
+    FlatSlot *slot = nullptr;
+    if (this->freeSlots.empty()) {
+        slot = &this->slots.emplace_back();
+    } else {
+        slot = this->freeSlots.back();
+        this->freeSlots.pop_back();
+    }
+
+    slot->kind = kind;
+    slot->pointer = pointer;
+    this->slotsByPath.emplace(pathKey(*pointer), slot);
+    FlatStorage::read(*slot, document);
+    this->used.fetch_add(1, std::memory_order_relaxed);
+
+    return slot;
+}
+
+void
+FlatStorage::release(FlatSlot *slot)
+{
+    std::lock_guard lock(this->mutex);
+
+    this->unindex(*slot);
+    slot->pointer = nullptr;
+    slot->state.store(FlatSlot::State::Empty, std::memory_order_release);
+    this->freeSlots.push_back(slot);
+    this->used.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void
+FlatStorage::move(FlatSlot &slot, const rapidjson::Pointer *pointer)
+{
+    std::lock_guard lock(this->mutex);
+
+    this->unindex(slot);
+    slot.pointer = pointer;
+    this->slotsByPath.emplace(pathKey(*pointer), &slot);
+}
+
+void
+FlatStorage::unindex(FlatSlot &slot)
+{
+    auto [it, end] = this->slotsByPath.equal_range(pathKey(*slot.pointer));
+    for (; it != end; ++it) {
+        if (it->second == &slot) {
+            this->slotsByPath.erase(it);
+            return;
+        }
+    }
+}
+
+bool
+FlatStorage::store(FlatSlot &slot, std::uint64_t bits, bool compare)
+{
+    std::lock_guard lock(this->mutex);
+
+    auto state = slot.state.load(std::memory_order_relaxed);
+    auto hasValue =
+        state == FlatSlot::State::Clean || state == FlatSlot::State::Dirty;
+
+    if (compare && hasValue &&
+        slot.bits.load(std::memory_order_relaxed) == bits) {
+        return false;
+    }
+
+    slot.bits.store(bits, std::memory_order_relaxed);
+
+    if (state != FlatSlot::State::Dirty) {
+        this->dirtySlots.push_back(&slot);
+        this->dirty.store(true, std::memory_order_release);
+    }
+
+    slot.state.store(FlatSlot::State::Dirty, std::memory_order_release);
+
+    return true;
+}
+
+void
+FlatStorage::reload(const rapidjson::Value &document,
+                    const rapidjson::Pointer *changed)
+{
+    if (this->empty()) {
+        return;
+    }
+
+    std::lock_guard lock(this->mutex);
+
+    if (changed == nullptr) {
+        for (auto &slot : this->slots) {
+            if (slot.pointer != nullptr) {
+                FlatStorage::read(slot, document);
+            }
+        }
+
+        this->dirtySlots.clear();
+        this->dirty.store(false, std::memory_order_relaxed);
+        return;
+    }
+
+    // Slots above the changed path, then the slots at & inside it
+    std::string key;
+    for (std::size_t i = 0; i < changed->GetTokenCount(); ++i) {
+        auto [it, end] = this->slotsByPath.equal_range(std::string_view(key));
+        for (; it != end; ++it) {
+            FlatStorage::read(*it->second, document);
+        }
+
+        appendTokenKey(key, changed->GetTokens()[i]);
+    }
+
+    for (auto it = this->slotsByPath.lower_bound(std::string_view(key));
+         it != this->slotsByPath.end() && it->first.starts_with(key); ++it) {
+        FlatStorage::read(*it->second, document);
+    }
+}
+
+void
+FlatStorage::read(FlatSlot &slot, const rapidjson::Value &document)
+{
+    const auto *value = slot.pointer->Get(document);
+    if (value == nullptr) {
+        slot.state.store(FlatSlot::State::Unset, std::memory_order_release);
+        return;
+    }
+
+    slot.bits.store(FlatStorage::fromJSON(slot.kind, *value),
+                    std::memory_order_relaxed);
+    slot.state.store(FlatSlot::State::Clean, std::memory_order_release);
+}
+
+std::size_t
+FlatStorage::flush(rapidjson::Document &document,
+                   const rapidjson::Pointer *inside)
+{
+    if (!this->dirty.load(std::memory_order_acquire)) {
+        return 0;
+    }
+
+    std::lock_guard lock(this->mutex);
+
+    std::size_t flushed = 0;
+    std::size_t kept = 0;
+
+    for (std::size_t i = 0; i < this->dirtySlots.size(); ++i) {
+        auto *slot = this->dirtySlots[i];
+        if (slot->pointer == nullptr ||
+            slot->state.load(std::memory_order_relaxed) !=
+                FlatSlot::State::Dirty) {
+            continue;
+        }
+
+        if (inside != nullptr && !isInside(*slot->pointer, *inside)) {
+            this->dirtySlots[kept++] = slot;
+            continue;
+        }
+
+        auto value = FlatStorage::toJSON(
+            slot->kind, slot->bits.load(std::memory_order_relaxed));
+        slot->pointer->Set(document, value);
+        slot->state.store(FlatSlot::State::Clean, std::memory_order_release);
+        ++flushed;
+    }
+
+    this->dirtySlots.resize(kept);
+    this->dirty.store(kept != 0, std::memory_order_relaxed);
+
+    return flushed;
+}
+
+std::size_t
+FlatStorage::size() const
+{
+    std::lock_guard lock(this->mutex);
+
+    return this->slots.size() - this->freeSlots.size();
+}
+
+}  // namespace pajlada::Settings::detail
@@ -0,0 +1,155 @@
+#include <algorithm>
+#include <numeric>
+#include <pajlada/settings/detail/frozenregistry.hpp>
+#include <pajlada/settings/key.hpp>
+
+namespace pajlada::Settings::detail {
+
+namespace {
+
+struct Item {
+    std::uint64_t hash;
+    std::string_view path;
+    const std::shared_ptr<SettingData> *setting;
+};
+
+}  // namespace
+
+std::uint64_t
+FrozenRegistry::indexHash(std::uint64_t hash, std::uint32_t seed)
+{
+    // splitmix64 finalizer
+    auto x = hash ^ (seed * 0x9E3779B97F4A7C15ULL);
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+void
+FrozenRegistry::build(const Registry &registry, std::uint32_t maxSeed)
+{
+    this->seeds.clear();
+    this->entries.clear();
+    this->overflow.clear();
+
+    maxSeed = std::min(maxSeed, OVERFLOW_SEED - 1);
+
+    if (registry.empty()) {
+        return;
+    }
+
+    // A few spare entries keep the seed search for the last buckets short
+    const auto numEntries = registry.size() + registry.size() / 4 + 1;
+    const auto numBuckets = std::max<std::size_t>(1, registry.size() / 2);
+
+    std::vector<std::vector<Item>> buckets(numBuckets);
+    for (const auto &[path, setting] : registry) {
+        auto hash = fnv1a(path);
+        buckets[hash % numBuckets].push_back({hash, path, &setting});
+    }
+
+    // Place the largest buckets first, while most entries are still free
+    std::vector<std::size_t> order(numBuckets);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+                     [&buckets](std::size_t lhs, std::size_t rhs) {
+                         return buckets[lhs].size() > buckets[rhs].size();
+                     });
+
+    this->seeds.assign(numBuckets, 0);
+    this->entries.resize(numEntries);
+
+    std::vector<bool> taken(numEntries, false);
+    std::vector<std::size_t> positions;
+
+    for (auto bucketIndex : order) {
+        const auto &bucket = buckets[bucketIndex];
+        if (bucket.empty()) {
+            break;
+        }
+
+        // Seed 0 marks an empty bucket
+        for (std::uint32_t seed = 1;; ++seed) {
+            if (seed > maxSeed) {
+                // Paths sharing their whole hash never get placed
+                for (const auto &item : bucket) {
+                    this->overflow.push_back({
+                        .path = item.path,
+                        .setting = *item.setting,
+                    });
+                }
+                this->seeds[bucketIndex] = OVERFLOW_SEED;
+                break;
+            }
+
+            positions.clear();
+
+            bool placed = true;
+            for (const auto &item : bucket) {
+                auto position = indexHash(item.hash, seed) % numEntries;
+                if (taken[position] ||
+                    std::find(positions.begin(), positions.end(), position) !=
+                        positions.end()) {
+                    placed = false;
+                    break;
+                }
+                positions.push_back(position);
+            }
+
+            if (!placed) {
+                continue;
+            }
+
+            for (std::size_t i = 0; i < bucket.size(); ++i) {
+                taken[positions[i]] = true;
+                this->entries[positions[i]] = {
+                    .path = bucket[i].path,
+                    .setting = *bucket[i].setting,
+                };
+            }
+            this->seeds[bucketIndex] = seed;
+            break;
+        }
+    }
+
+    std::sort(this->overflow.begin(), this->overflow.end(),
+              [](const Entry &lhs, const Entry &rhs) {
+                  return lhs.path < rhs.path;
+              });
+}
+
+const std::shared_ptr<SettingData> *
+FrozenRegistry::find(std::string_view path) const
+{
+    if (this->entries.empty()) {
+        return nullptr;
+    }
+
+    auto hash = fnv1a(path);
+    auto seed = this->seeds[hash % this->seeds.size()];
+    if (seed == 0) {
+        return nullptr;
+    }
+
+    if (seed == OVERFLOW_SEED) {
+        auto it = std::lower_bound(this->overflow.begin(), this->overflow.end(),
+                                   path, [](const Entry &entry, auto rhs) {
+                                       return entry.path < rhs;
+                                   });
+        if (it == this->overflow.end() || it->path != path) {
+            return nullptr;
+        }
+
+        return &it->setting;
+    }
+
+    const auto &entry =
+        this->entries[indexHash(hash, seed) % this->entries.size()];
+    if (entry.setting == nullptr || entry.path != path) {
+        return nullptr;
+    }
+
+    return &entry.setting;
+}
+
+}  // namespace pajlada::Settings::detail
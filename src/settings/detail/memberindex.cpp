@@ -0,0 +1,169 @@
+#include <pajlada/settings/detail/memberindex.hpp>
+
+namespace pajlada::Settings::detail {
+
+namespace {
+
+std::string_view
+nameView(const rapidjson::Value &name)
+{
+    return {name.GetString(), name.GetStringLength()};
+}
+
+}  // namespace
+
+rapidjson::Value *
+MemberIndex::find(rapidjson::Value &object, std::string_view name)
+{
+    const auto count = object.MemberCount();
+    const auto minimum = this->threshold.load(std::memory_order_relaxed);
+
+    if (minimum == 0 || count < minimum) {
+        return findLinear(object, name);
+    }
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    auto &table = this->tables[&object];
+    auto members = object.MemberBegin();
+    const auto *first = &*members;
+
+    if (table.members != first || table.count > count) {
+        // Reallocated, replaced or members were removed
+        table.positions.clear();
+        table.positions.reserve(count);
+        table.members = first;
+        table.count = 0;
+    }
+
+    // Members are appended at the end
+    for (auto i = table.count; i < count; ++i) {
+        // Like FindMember, the first of duplicate names wins
+        table.positions.try_emplace(nameView((members + i)->name), i);
+    }
+    table.count = count;
+
+    auto it = table.positions.find(name);
+    if (it == table.positions.end()) {
+        return nullptr;
+    }
+
+    auto &member = *(members + it->second);
+    if (nameView(member.name) != name) {
+        // The object was changed without going through the SettingManager
+        table.members = nullptr;
+        return findLinear(object, name);
+    }
+
+    return &member.value;
+}
+
+bool
+MemberIndex::remove(rapidjson::Value &object, std::string_view name)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    auto members = object.MemberBegin();
+    const auto count = object.MemberCount();
+
+    Table *table = nullptr;
+    if (auto it = this->tables.find(&object); it != this->tables.end()) {
+        // Only kept up to date if it's up to date now
+        if (it->second.members == &*members && it->second.count == count) {
+            table = &it->second;
+        } else {
+            this->tables.erase(it);
+        }
+    }
+
+    rapidjson::SizeType position = 0;
+    if (table != nullptr) {
+        auto it = table->positions.find(name);
+        if (it == table->positions.end()) {
+            return false;
+        }
+        position = it->second;
+
+        if (nameView((members + position)->name) != name) {
+            // The object was changed without going through the SettingManager
+            this->tables.erase(&object);
+            table = nullptr;
+        }
+    }
+
+    if (table == nullptr) {
+        auto member = object.FindMember(rapidjson::Value(rapidjson::StringRef(
+            name.data(), static_cast<rapidjson::SizeType>(name.size()))));
+        if (member == object.MemberEnd()) {
+            return false;
+        }
+        position = static_cast<rapidjson::SizeType>(member - members);
+    }
+
+    const auto last = count - 1;
+
+    if (table != nullptr) {
+        table->positions.erase(nameView((members + position)->name));
+
+        // Names of short strings live in the member, so drop the view into
+        // the last member before it's moved
+        if (position != last) {
+            auto it = table->positions.find(nameView((members + last)->name));
+            if (it != table->positions.end() && it->second == last) {
+                table->positions.erase(it);
+            }
+        }
+    }
+
+    object.RemoveMember(members + position);
+
+    if (table != nullptr) {
+        if (position != last) {
+            table->positions.try_emplace(nameView((members + position)->name),
+                                         position);
+        }
+        table->count = last;
+    }
+
+    return true;
+}
+
+void
+MemberIndex::clear()
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    this->tables.clear();
+}
+
+void
+MemberIndex::setThreshold(std::size_t _threshold)
+{
+    this->threshold.store(_threshold, std::memory_order_relaxed);
+
+    if (_threshold == 0) {
+        this->clear();
+    }
+}
+
+std::size_t
+MemberIndex::size() const
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    return this->tables.size();
+}
+
+rapidjson::Value *
+MemberIndex::findLinear(rapidjson::Value &object, std::string_view name)
+{
+    auto member = object.FindMember(rapidjson::Value(rapidjson::StringRef(
+        name.data(), static_cast<rapidjson::SizeType>(name.size()))));
+    if (member == object.MemberEnd()) {
+        return nullptr;
+    }
+
+    return &member->value;
+}
+
+}  // namespace pajlada::Settings::detail
@@ -0,0 +1,49 @@
+#include <pajlada/settings/detail/notificationbatch.hpp>
+#include <utility>
+#include <vector>
+
+namespace pajlada::Settings::detail {
+
+namespace {
+
+thread_local int depth = 0;
+thread_local std::vector<std::function<void()>> callbacks;
+
+}  // namespace
+
+NotificationBatch::NotificationBatch()
+{
+    ++depth;
+}
+
+NotificationBatch::~NotificationBatch()
+{
+    if (--depth > 0) {
+        return;
+    }
+
+    // Callbacks may open batches of their own, those run their own callbacks
+    auto pending = std::exchange(callbacks, {});
+    for (const auto &callback : pending) {
+        callback();
+    }
+}
+
+bool
+NotificationBatch::isOpen()
+{
+    return depth > 0;
+}
+
+void
+NotificationBatch::onEnd(std::function<void()> callback)
+{
+    if (depth == 0) {
+        callback();
+        return;
+    }
+
+    callbacks.push_back(std::move(callback));
+}
+
+}  // namespace pajlada::Settings::detail
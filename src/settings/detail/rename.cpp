@@ -1,4 +1,5 @@
 #include <pajlada/settings/detail/rename.hpp>
+#include <pajlada/settings/trace.hpp>
 
 #ifdef _WIN32
 #define WIN32_LEAN_AND_MEAN
@@ -11,6 +12,11 @@ void
 renameFile(const std::filesystem::path &from, const std::filesystem::path &to,
            std::error_code &ec)
 {
+    Trace::Span span("renameFile");
+    if (span.active()) {
+        span.setDetail(from.string() + " -> " + to.string());
+    }
+
 #ifdef _WIN32
     // MOVEFILE_WRITE_THROUGH to bypass the filesystem cache
     if (MoveFileExW(from.c_str(), to.c_str(),
@@ -0,0 +1,14 @@
+#include <atomic>
+#include <pajlada/settings/key.hpp>
+
+namespace pajlada::Settings::detail {
+
+std::uint32_t
+nextKeySlot()
+{
+    static std::atomic<std::uint32_t> nextSlot{0};
+
+    return nextSlot.fetch_add(1, std::memory_order_relaxed);
+}
+
+}  // namespace pajlada::Settings::detail
@@ -0,0 +1,92 @@
+#include <algorithm>
+#include <pajlada/settings/listenerprofiler.hpp>
+
+namespace pajlada::Settings {
+
+void
+ListenerProfiler::setEnabled(bool _enabled)
+{
+    this->enabled.store(_enabled, std::memory_order_relaxed);
+}
+
+void
+ListenerProfiler::setSlowThreshold(std::chrono::nanoseconds threshold,
+                                   SlowCallback callback)
+{
+    std::lock_guard lock(this->mutex);
+
+    this->slowThreshold = threshold;
+    if (callback) {
+        this->slowCallback =
+            std::make_shared<const SlowCallback>(std::move(callback));
+    } else {
+        this->slowCallback.reset();
+    }
+}
+
+std::vector<ListenerProfile>
+ListenerProfiler::topSlowest(std::size_t n) const
+{
+    std::vector<ListenerProfile> profiles;
+
+    {
+        std::lock_guard lock(this->mutex);
+
+        profiles.reserve(this->entries.size());
+        for (const auto &[key, profile] : this->entries) {
+            profiles.push_back(profile);
+        }
+    }
+
+    n = std::min(n, profiles.size());
+    std::partial_sort(profiles.begin(), profiles.begin() + n, profiles.end(),
+                      [](const auto &lhs, const auto &rhs) {
+                          return lhs.max > rhs.max;
+                      });
+    profiles.resize(n);
+
+    return profiles;
+}
+
+void
+ListenerProfiler::reset()
+{
+    std::lock_guard lock(this->mutex);
+
+    this->entries.clear();
+}
+
+void
+ListenerProfiler::record(const std::string &path, const std::string &label,
+                         std::chrono::nanoseconds duration)
+{
+    std::shared_ptr<const SlowCallback> callback;
+    ListenerProfile snapshot;
+
+    {
+        std::lock_guard lock(this->mutex);
+
+        auto [it, inserted] = this->entries.try_emplace({path, label});
+        auto &profile = it->second;
+        if (inserted) {
+            profile.path = path;
+            profile.label = label;
+        }
+
+        ++profile.calls;
+        profile.total += duration;
+        profile.max = std::max(profile.max, duration);
+
+        if (this->slowCallback && duration > this->slowThreshold) {
+            callback = this->slowCallback;
+            snapshot = profile;
+        }
+    }
+
+    // Invoked outside of the lock so the callback can query the profiler
+    if (callback) {
+        (*callback)(snapshot, duration);
+    }
+}
+
+}  // namespace pajlada::Settings
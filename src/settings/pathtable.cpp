@@ -0,0 +1,211 @@
+#include <bit>
+#include <mutex>
+#include <pajlada/settings/pathtable.hpp>
+
+namespace pajlada::Settings {
+
+namespace {
+
+struct ChunkIndex {
+    std::size_t chunk;
+    std::size_t offset;
+};
+
+template <std::size_t FirstChunkBits>
+ChunkIndex
+chunkIndex(std::uint32_t id)
+{
+    auto n = static_cast<std::uint64_t>(id) + (1ULL << FirstChunkBits);
+    auto chunk = static_cast<std::size_t>(std::bit_width(n)) - 1 -
+                 FirstChunkBits;
+
+    auto chunkStart = 1ULL << (chunk + FirstChunkBits);
+
+    return {
+        .chunk = chunk,
+        .offset = static_cast<std::size_t>(n - chunkStart),
+    };
+}
+
+}  // namespace
+
+PathID
+PathID::intern(std::string_view path)
+{
+    return PathTable::instance().intern(path);
+}
+
+PathID
+PathID::retain() const
+{
+    PathTable::instance().retain(*this);
+
+    return *this;
+}
+
+void
+PathID::release() const
+{
+    PathTable::instance().release(*this);
+}
+
+const std::string &
+PathID::str() const
+{
+    return PathTable::instance().get(*this);
+}
+
+PathTable &
+PathTable::instance()
+{
+    static PathTable table;
+
+    return table;
+}
+
+PathTable::PathTable()
+{
+    // ID 0 is the empty path, so a default-constructed PathID is valid
+    this->intern({});
+}
+
+PathTable::~PathTable()
+{
+    for (auto &chunk : this->chunks) {
+        delete[] chunk.load(std::memory_order_relaxed);
+    }
+}
+
+PathID
+PathTable::intern(std::string_view path)
+{
+    {
+        std::shared_lock lock(this->mutex);
+
+        if (auto it = this->ids.find(path); it != this->ids.end()) {
+            // release only removes entries while holding the lock exclusively
+            this->entry(PathID(it->second))
+                .refs.fetch_add(1, std::memory_order_relaxed);
+            return PathID(it->second);
+        }
+    }
+
+    std::unique_lock lock(this->mutex);
+
+    // Someone else might have interned it while we didn't hold the lock
+    if (auto it = this->ids.find(path); it != this->ids.end()) {
+        this->entry(PathID(it->second))
+            .refs.fetch_add(1, std::memory_order_relaxed);
+        return PathID(it->second);
+    }
+
+    std::uint32_t id{};
+    if (!this->freeIDs.empty()) {
+        id = this->freeIDs.back();
+        this->freeIDs.pop_back();
+    } else {
+        id = this->count++;
+
+        auto [chunk, offset] = chunkIndex<FIRST_CHUNK_BITS>(id);
+        if (this->chunks[chunk].load(std::memory_order_relaxed) == nullptr) {
+            this->chunks[chunk].store(new Entry[FIRST_CHUNK_SIZE << chunk],
+                                      std::memory_order_release);
+        }
+    }
+
+    auto &stored = this->entry(PathID(id));
+    stored.path.assign(path);
+    stored.refs.store(1, std::memory_order_relaxed);
+
+    this->ids.emplace(stored.path, id);
+    this->stringBytes += stored.path.capacity();
+
+    return PathID(id);
+}
+
+void
+PathTable::retain(PathID id)
+{
+    if (id.empty()) {
+        return;
+    }
+
+    this->entry(id).refs.fetch_add(1, std::memory_order_relaxed);
+}
+
+void
+PathTable::release(PathID id)
+{
+    if (id.empty()) {
+        return;
+    }
+
+    auto &stored = this->entry(id);
+    if (stored.refs.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+        return;
+    }
+
+    std::unique_lock lock(this->mutex);
+
+    // The path might have been interned again, or removed by another
+    // release that raced with us, while we didn't hold the lock
+    if (stored.refs.load(std::memory_order_relaxed) != 0) {
+        return;
+    }
+    auto it = this->ids.find(stored.path);
+    if (it == this->ids.end() || it->second != id.value()) {
+        return;
+    }
+
+    this->ids.erase(it);
+    this->stringBytes -= stored.path.capacity();
+    std::string().swap(stored.path);
+    this->freeIDs.push_back(id.value());
+}
+
+PathID
+PathTable::find(std::string_view path) const
+{
+    std::shared_lock lock(this->mutex);
+
+    auto it = this->ids.find(path);
+    if (it == this->ids.end()) {
+        return {};
+    }
+
+    return PathID(it->second);
+}
+
+const std::string &
+PathTable::get(PathID id) const
+{
+    // Whoever handed us the ID got it from `intern`, which happens-before
+    // any use of the ID, so the string is fully constructed
+    return this->entry(id).path;
+}
+
+PathTable::Entry &
+PathTable::entry(PathID id) const
+{
+    auto [chunk, offset] = chunkIndex<FIRST_CHUNK_BITS>(id.value());
+
+    return this->chunks[chunk].load(std::memory_order_acquire)[offset];
+}
+
+std::size_t
+PathTable::size() const
+{
+    std::shared_lock lock(this->mutex);
+
+    return this->count - this->freeIDs.size();
+}
+
+std::size_t
+PathTable::bytes() const
+{
+    std::shared_lock lock(this->mutex);
+
+    return this->stringBytes;
+}
+
+}  // namespace pajlada::Settings
@@ -1,27 +1,129 @@
+#include <chrono>
+#include <mutex>
 #include <pajlada/settings/settingdata.hpp>
+#include <pajlada/settings/trace.hpp>
 #include <utility>
 
 namespace pajlada::Settings {
 
-SettingData::SettingData(std::string _path,
-                         std::weak_ptr<SettingManager> _instance)
-    : path(std::move(_path))
-    , instance(std::move(_instance))
+SettingData::SettingData(PathID _path,
+                         const std::shared_ptr<SettingManager> &_instance,
+                         const rapidjson::Pointer *_pointer)
+    : path(_path.retain())
+    // A pointer over static tokens is shared instead of parsing the path again
+    , ownedPointer(std::make_unique<const rapidjson::Pointer>(
+          _pointer != nullptr
+              ? rapidjson::Pointer(_pointer->GetTokens(),
+                                   _pointer->GetTokenCount())
+              : rapidjson::Pointer(_path.str())))
+    , pointer(this->ownedPointer.get())
+    , instance(_instance)
+    , statistics(_instance->statistics)
+    , profiler(_instance->profiler)
+    , flatStorage(_instance->flatStorage)
+    , frozen(_instance->frozen)
 {
 }
 
+SettingData::~SettingData()
+{
+    if (auto *slot = this->flatSlot.load(std::memory_order_acquire)) {
+        this->flatStorage->release(slot);
+    }
+
+    this->path.load(std::memory_order_relaxed).release();
+}
+
 const std::string &
 SettingData::getPath() const
 {
-    return this->path;
+    return this->path.load(std::memory_order_acquire).str();
+}
+
+PathID
+SettingData::getPathID() const
+{
+    return this->path.load(std::memory_order_acquire);
+}
+
+Signals::Connection
+SettingData::connect(UpdatedSignal::FunctionSignature slot, std::string label)
+{
+    Signals::Connection connection;
+    if (this->profiler->isEnabled()) {
+        // The slot can only be invoked through our own signal, so `this` outlives it
+        connection = this->updated.connect(
+            [this, slot = std::move(slot), label = std::move(label)](
+                const rapidjson::Value &value, const SignalArgs &args) {
+                if (!this->profiler->isEnabled()) {
+                    slot(value, args);
+                    return;
+                }
+
+                auto start = std::chrono::steady_clock::now();
+                slot(value, args);
+                this->profiler->record(
+                    this->getPath(), label,
+                    std::chrono::steady_clock::now() - start);
+            });
+    } else {
+        connection = this->updated.connect(std::move(slot));
+    }
+
+    std::lock_guard lock(this->listenersMutex);
+
+    std::erase_if(this->listeners, [](const auto &listener) {
+        return !listener.isConnected();
+    });
+    this->listeners.push_back(connection);
+
+    return connection;
 }
 
 void
 SettingData::notifyUpdate(const rapidjson::Value &value, SignalArgs args)
 {
+    Trace::Span span("notifyUpdate");
+    span.setDetail(this->getPathID().view());
+
     ++this->updateIteration;
 
+    // The value is written, listeners may start another update
+    this->releaseUpdateLock();
+
+    if (span.active()) {
+        span.setCount(static_cast<std::int64_t>(this->getListenerCount()));
+    }
+
     this->updated.invoke(value, args);
+
+    this->resumeWaiters(value, args);
+}
+
+SettingData::UpdateLock::UpdateLock(SettingData &_setting)
+    : setting(_setting)
+{
+    this->setting.updateMutex.lock();
+    this->setting.updateOwner.store(std::this_thread::get_id(),
+                                    std::memory_order_relaxed);
+}
+
+SettingData::UpdateLock::~UpdateLock()
+{
+    // Does nothing if notifyUpdate already released it
+    this->setting.releaseUpdateLock();
+}
+
+void
+SettingData::releaseUpdateLock()
+{
+    if (this->updateOwner.load(std::memory_order_relaxed) !=
+        std::this_thread::get_id()) {
+        return;
+    }
+
+    this->updateOwner.store(std::thread::id(), std::memory_order_relaxed);
+    this->updateMutex.unlock();
 }
 
 int
@@ -30,6 +132,139 @@ SettingData::getUpdateIteration() const
     return this->updateIteration;
 }
 
+bool
+SettingData::isFrozen() const
+{
+    return this->frozen->load(std::memory_order_acquire);
+}
+
+std::size_t
+SettingData::getListenerCount() const
+{
+    std::lock_guard lock(this->listenersMutex);
+
+    std::erase_if(this->listeners, [](const auto &listener) {
+        return !listener.isConnected();
+    });
+
+    return this->listeners.size();
+}
+
+std::size_t
+SettingData::getHandleCount() const
+{
+    return this->handleCount.load(std::memory_order_relaxed);
+}
+
+detail::ManagerStats &
+SettingData::stats() const
+{
+    return *this->statistics;
+}
+
+void
+SettingData::addWaiter(detail::ChangeWaiter *waiter)
+{
+    std::lock_guard<std::mutex> lock(this->waitersMutex);
+
+    waiter->next = this->waiters;
+    waiter->list = &this->waiters;
+    this->waiters = waiter;
+}
+
+void
+SettingData::removeWaiter(detail::ChangeWaiter *waiter)
+{
+    std::lock_guard<std::mutex> lock(this->waitersMutex);
+
+    // Already resumed, or being resumed
+    if (waiter->list == nullptr) {
+        return;
+    }
+
+    // Also unlinks waiters a notification hasn't reached yet, so it never
+    // touches them again
+    for (auto **it = waiter->list; *it != nullptr; it = &(*it)->next) {
+        if (*it == waiter) {
+            *it = waiter->next;
+            break;
+        }
+    }
+
+    waiter->next = nullptr;
+    waiter->list = nullptr;
+}
+
+void
+SettingData::resumeWaiters(const rapidjson::Value &value,
+                           const SignalArgs &args)
+{
+    // Waiters of this notification, removeWaiter unlinks them from here
+    detail::ChangeWaiter *pending = nullptr;
+
+    {
+        std::lock_guard<std::mutex> lock(this->waitersMutex);
+
+        // Detach the list & reverse it so waiters are resumed in the order
+        // they started waiting
+        auto *it = this->waiters;
+        this->waiters = nullptr;
+        while (it != nullptr) {
+            auto *next = it->next;
+            it->list = &pending;
+            it->next = pending;
+            pending = it;
+            it = next;
+        }
+    }
+
+    while (true) {
+        detail::ChangeWaiter *waiter = nullptr;
+
+        {
+            // A waiter destroyed before we get to it is no longer in the list
+            std::lock_guard<std::mutex> lock(this->waitersMutex);
+            waiter = pending;
+            if (waiter == nullptr) {
+                break;
+            }
+            pending = waiter->next;
+            waiter->next = nullptr;
+            waiter->list = nullptr;
+        }
+
+        // The waiter might be destroyed as soon as it's resumed
+        waiter->capture(waiter, value, args);
+        waiter->handle.resume();
+    }
+}
+
+void
+SettingData::copyJSON(rapidjson::Document &out) const
+{
+    if (auto *slot = this->flatSlot.load(std::memory_order_acquire)) {
+        switch (slot->state.load(std::memory_order_acquire)) {
+            case detail::FlatSlot::State::Unset:
+                return;
+
+            case detail::FlatSlot::State::Clean:
+            case detail::FlatSlot::State::Dirty: {
+                auto value = detail::FlatStorage::toJSON(
+                    slot->kind, slot->bits.load(std::memory_order_relaxed));
+                out.CopyFrom(value, out.GetAllocator());
+                return;
+            }
+
+            case detail::FlatSlot::State::Empty:
+                break;
+        }
+    }
+
+    if (const auto *value = this->get()) {
+        out.CopyFrom(*value, out.GetAllocator());
+    }
+}
+
 rapidjson::Value *
 SettingData::get() const
 {
@@ -38,7 +273,112 @@ SettingData::get() const
         return nullptr;
     }
 
-    return locked->get(this->path);
+    return locked->get(this->getPointer());
+}
+
+bool
+SettingData::eraseMember(std::string_view key, SignalArgs args)
+{
+    auto locked = this->instance.lock();
+    if (!locked) {
+        return false;
+    }
+
+    return locked->eraseMember(*this, key, std::move(args));
+}
+
+bool
+SettingData::eraseElement(std::size_t index, SignalArgs args)
+{
+    auto locked = this->instance.lock();
+    if (!locked) {
+        return false;
+    }
+
+    return locked->eraseArrayValue(this->getPath(), this->getPointer(),
+                                   static_cast<rapidjson::SizeType>(index),
+                                   std::move(args));
+}
+
+void
+SettingData::relocate(PathID newPath)
+{
+    auto newPointer =
+        std::make_unique<const rapidjson::Pointer>(newPath.str());
+
+    std::lock_guard lock(this->pointerMutex);
+
+    // The slot reads its pointer under the FlatStorage's lock, so it's moved
+    // over first
+    if (auto *slot = this->flatSlot.load(std::memory_order_acquire)) {
+        this->flatStorage->move(*slot, newPointer.get());
+    }
+    this->pointer.store(newPointer.get(), std::memory_order_release);
+    this->retiredPointer =
+        std::exchange(this->ownedPointer, std::move(newPointer));
+
+    this->path.exchange(newPath.retain(), std::memory_order_acq_rel)
+        .release();
+}
+
+detail::FlatSlot *
+SettingData::getFlatSlot(detail::FlatSlot::Kind kind)
+{
+    auto *slot = this->flatSlot.load(std::memory_order_acquire);
+
+    if (slot == nullptr) {
+        auto locked = this->instance.lock();
+        if (!locked) {
+            return nullptr;
+        }
+
+        // Held until the slot is published, so relocate moves it along
+        std::lock_guard lock(this->pointerMutex);
+
+        auto *acquired = this->flatStorage->acquire(
+            kind, this->ownedPointer.get(), locked->document);
+        if (this->flatSlot.compare_exchange_strong(slot, acquired)) {
+            slot = acquired;
+        } else {
+            // Another thread acquired one first, `slot` now holds theirs
+            this->flatStorage->release(acquired);
+        }
+    }
+
+    if (slot->kind != kind) {
+        return nullptr;
+    }
+
+    return slot;
+}
+
+namespace detail {
+
+SettingDataHandle::SettingDataHandle(const std::shared_ptr<SettingData> &_data)
+    : data(_data)
+{
+    if (_data) {
+        ++_data->handleCount;
+    }
+}
+
+SettingDataHandle::SettingDataHandle(const SettingDataHandle &other)
+    : data(other.data)
+{
+    // The other handle keeps the count above zero, so the data can't be
+    // compacted away between the lock & the increment
+    if (auto locked = this->data.lock()) {
+        ++locked->handleCount;
+    }
+}
+
+SettingDataHandle::~SettingDataHandle()
+{
+    if (auto locked = this->data.lock()) {
+        --locked->handleCount;
+    }
 }
 
+}  // namespace detail
+
 }  // namespace pajlada::Settings
@@ -1,19 +1,311 @@
 #include <rapidjson/prettywriter.h>
 #include <rapidjson/writer.h>
 
+#include <cassert>
 #include <fstream>
 #include <pajlada/settings/backup.hpp>
+#include <pajlada/settings/detail/notificationbatch.hpp>
 #include <pajlada/settings/detail/realpath.hpp>
 #include <pajlada/settings/internal.hpp>
 #include <pajlada/settings/settingdata.hpp>
 #include <pajlada/settings/settingmanager.hpp>
+#include <pajlada/settings/trace.hpp>
 #include <sstream>
 #include <string>
+#include <thread>
 
 namespace pajlada::Settings {
 
+namespace {
+
+/// A member is a name & a value
+constexpr std::size_t memberSize = 2 * sizeof(rapidjson::Value);
+
+/// Round up like MemoryPoolAllocator does
+std::size_t
+poolAligned(std::size_t bytes)
+{
+    return (bytes + 7) & ~std::size_t{7};
+}
+
+/// Estimated pool bytes of a string, 0 if it fits in the value itself
+std::size_t
+estimateStringBytes(const rapidjson::Value &string)
+{
+    // RapidJSON stores strings up to this length inline (ShortString)
+    constexpr std::size_t maxInlineLength = sizeof(rapidjson::Value) - 3;
+
+    auto length = static_cast<std::size_t>(string.GetStringLength());
+    if (length <= maxInlineLength) {
+        return 0;
+    }
+
+    return poolAligned(length + 1);
+}
+
+/// Estimated pool bytes owned by `value`, not counting the value itself
+std::size_t
+estimatePoolBytes(const rapidjson::Value &value)
+{
+    if (value.IsString()) {
+        return estimateStringBytes(value);
+    }
+
+    std::size_t bytes = 0;
+
+    if (value.IsObject()) {
+        bytes += poolAligned(value.MemberCapacity() * memberSize);
+        for (auto it = value.MemberBegin(); it != value.MemberEnd(); ++it) {
+            bytes += estimateStringBytes(it->name);
+            bytes += estimatePoolBytes(it->value);
+        }
+    } else if (value.IsArray()) {
+        bytes += poolAligned(value.Capacity() * sizeof(rapidjson::Value));
+        for (auto it = value.Begin(); it != value.End(); ++it) {
+            bytes += estimatePoolBytes(*it);
+        }
+    }
+
+    return bytes;
+}
+
+std::string_view
+pathView(const std::string &path)
+{
+    return path;
+}
+
+std::string_view
+pathView(PathID path)
+{
+    return path.view();
+}
+
+/// Same as rapidjson::Pointer::Get for one token, with members of large
+/// objects looked up through `members`
+rapidjson::Value *
+findChild(rapidjson::Value &value, std::string_view token,
+          rapidjson::SizeType index, detail::MemberIndex &members)
+{
+    if (value.IsObject()) {
+        return members.find(value, token);
+    }
+
+    if (value.IsArray()) {
+        if (index == rapidjson::kPointerInvalidIndex || index >= value.Size()) {
+            return nullptr;
+        }
+        return &value[index];
+    }
+
+    return nullptr;
+}
+
+/// Same as rapidjson::Pointer::Create for one token, with members of large
+/// objects looked up through `members`
+rapidjson::Value *
+createChild(rapidjson::Value &value, std::string_view token,
+            rapidjson::SizeType index,
+            rapidjson::Document::AllocatorType &allocator,
+            detail::MemberIndex &members)
+{
+    if (value.IsArray() && token == "-") {
+        value.PushBack(rapidjson::Value().Move(), allocator);
+        return &value[value.Size() - 1];
+    }
+
+    if (index == rapidjson::kPointerInvalidIndex) {
+        if (!value.IsObject()) {
+            value.SetObject();
+        }
+    } else if (!value.IsArray() && !value.IsObject()) {
+        value.SetArray();
+    }
+
+    if (value.IsArray()) {
+        if (index >= value.Size()) {
+            value.Reserve(index + 1, allocator);
+            while (index >= value.Size()) {
+                value.PushBack(rapidjson::Value().Move(), allocator);
+            }
+        }
+        return &value[index];
+    }
+
+    if (auto *member = members.find(value, token)) {
+        return member;
+    }
+
+    value.AddMember(
+        rapidjson::Value(token.data(),
+                         static_cast<rapidjson::SizeType>(token.size()),
+                         allocator)
+            .Move(),
+        rapidjson::Value().Move(), allocator);
+    return &(value.MemberEnd() - 1)->value;
+}
+
+/// Resolve `pointer` like rapidjson::Pointer::Get, or like Create if
+/// `allocator` is set
+///
+/// Returns nullptr for invalid pointers & values that don't exist
+rapidjson::Value *
+resolvePointer(rapidjson::Value &root, const rapidjson::Pointer &pointer,
+               detail::MemberIndex &members,
+               rapidjson::Document::AllocatorType *allocator = nullptr)
+{
+    if (!pointer.IsValid()) {
+        return nullptr;
+    }
+
+    auto *value = &root;
+    const auto *tokens = pointer.GetTokens();
+
+    for (std::size_t i = 0; i < pointer.GetTokenCount(); ++i) {
+        const auto &token = tokens[i];
+        const std::string_view name(token.name, token.length);
+
+        value = allocator != nullptr ? createChild(*value, name, token.index,
+                                                   *allocator, members)
+                                     : findChild(*value, name, token.index,
+                                                 members);
+        if (value == nullptr) {
+            return nullptr;
+        }
+    }
+
+    return value;
+}
+
+/// Resolves JSON pointers one after another, walking only the tokens a path
+/// doesn't share with the previous one
+///
+/// Writing to a resolved value is fine, but any other change to the document
+/// invalidates the walker.
+class PathWalker
+{
+public:
+    PathWalker(rapidjson::Value &_root, detail::MemberIndex &_members)
+        : root(_root)
+        , members(_members)
+    {
+    }
+
+    /// Returns nullptr for invalid paths & values that don't exist
+    ///
+    /// If `allocator` is set, missing values are created as null the same
+    /// way rapidjson::Pointer::Create does.
+    rapidjson::Value *
+    walk(std::string_view path,
+         rapidjson::Document::AllocatorType *allocator = nullptr)
+    {
+        if (!this->split(path)) {
+            return nullptr;
+        }
+
+        // "-" appends a new array element every time, so it's never shared
+        std::size_t common = 0;
+        while (common < this->resolved.size() &&
+               common < this->tokens.size() &&
+               this->resolved[common].first == this->tokens[common] &&
+               this->tokens[common] != "-") {
+            ++common;
+        }
+        this->resolved.resize(common);
+
+        auto *value = common == 0 ? &this->root : this->resolved.back().second;
+        auto cacheable = true;
+
+        for (auto i = common; i < this->tokens.size(); ++i) {
+            const auto token = this->tokens[i];
+            const auto index = detail::tokenIndex(token);
+
+            value = allocator != nullptr
+                        ? createChild(*value, token, index, *allocator,
+                                      this->members)
+                        : findChild(*value, token, index, this->members);
+            if (value == nullptr) {
+                return nullptr;
+            }
+
+            cacheable = cacheable && token != "-";
+            if (cacheable) {
+                this->resolved.emplace_back(token, value);
+            }
+        }
+
+        return value;
+    }
+
+private:
+    /// Split `path` into unescaped tokens, returns false if it's invalid
+    bool
+    split(std::string_view path)
+    {
+        this->tokens.clear();
+        this->unescaped.clear();
+        // Views into `unescaped` must stay valid while we append to it
+        this->unescaped.reserve(path.size());
+
+        if (path.empty()) {
+            return true;
+        }
+
+        if (path.front() != '/') {
+            return false;
+        }
+
+        std::size_t start = 1;
+        while (true) {
+            auto end = std::min(path.find('/', start), path.size());
+            auto token = path.substr(start, end - start);
+
+            if (token.find('~') != std::string_view::npos) {
+                auto offset = this->unescaped.size();
+                for (std::size_t i = 0; i < token.size(); ++i) {
+                    if (token[i] != '~') {
+                        this->unescaped.push_back(token[i]);
+                        continue;
+                    }
+
+                    // Only ~0 & ~1 are valid escapes
+                    if (i + 1 == token.size() ||
+                        (token[i + 1] != '0' && token[i + 1] != '1')) {
+                        return false;
+                    }
+                    this->unescaped.push_back(token[++i] == '0' ? '~' : '/');
+                }
+                token = std::string_view(this->unescaped).substr(offset);
+            }
+
+            this->tokens.push_back(token);
+
+            if (end == path.size()) {
+                return true;
+            }
+            start = end + 1;
+        }
+    }
+
+    rapidjson::Value &root;
+    detail::MemberIndex &members;
+
+    /// The tokens of the previous path & the values they resolved to
+    std::vector<std::pair<std::string, rapidjson::Value *>> resolved;
+
+    std::vector<std::string_view> tokens;
+    std::string unescaped;
+};
+
+}  // namespace
+
 SettingManager::SettingManager()
     : document(rapidjson::kObjectType)
+    , statistics(std::make_shared<detail::ManagerStats>())
+    , profiler(std::make_shared<ListenerProfiler>())
+    , flatStorage(std::make_shared<detail::FlatStorage>())
+    , pendingLoads(std::make_shared<PendingLoads>())
+    , frozen(std::make_shared<std::atomic<bool>>(false))
 {
 }
 
@@ -25,28 +317,245 @@ SettingManager::~SettingManager()
     if (this->hasSaveMethodFlag(SaveMethod::SaveOnExit)) {
         this->save();
     }
+
+    // Complete the futures of loads nobody will apply anymore. We can't be
+    // locked through weak_from_this here, so they fail with Cancelled
+    std::vector<std::function<void()>> cancelled;
+    {
+        std::unique_lock lock(this->pendingLoads->mutex);
+        this->pendingLoads->closed = true;
+        cancelled.swap(this->pendingLoads->tasks);
+    }
+
+    for (auto &task : cancelled) {
+        task();
+    }
 }
 
 rapidjson::Value *
 SettingManager::get(const std::string &path)
 {
-    auto ptr = rapidjson::Pointer(path);
+    return this->get(rapidjson::Pointer(path));
+}
 
-    if (!ptr.IsValid()) {
+rapidjson::Value *
+SettingManager::get(const rapidjson::Pointer &pointer)
+{
+    if (!pointer.IsValid()) {
         // For invalid paths, i.e. "988934jksgrhjkh" or "jgkh34gjk" (missing /)
         return nullptr;
     }
 
-    return ptr.Get(this->document);
+    this->statistics->pointerResolutions.add();
+
+    return resolvePointer(this->document, pointer, this->memberIndex);
 }
 
 bool
 SettingManager::set(const std::string &path, const rapidjson::Value &value,
                     SignalArgs args)
+{
+    auto setting = this->getSetting(path);
+
+    return this->setImpl(path, rapidjson::Pointer(path), setting.get(), value,
+                         std::move(args));
+}
+
+int
+SettingManager::getVersion(const std::string &path)
+{
+    auto setting = this->getSetting(path);
+    if (!setting) {
+        return -1;
+    }
+
+    return setting->getUpdateIteration();
+}
+
+bool
+SettingManager::setIfVersion(const std::string &path,
+                             const rapidjson::Value &value,
+                             int expectedIteration, SignalArgs args)
+{
+    auto setting = this->getSetting(path);
+    if (!setting) {
+        return false;
+    }
+
+    auto updateLock = setting->lockForUpdate();
+
+    if (setting->getUpdateIteration() != expectedIteration) {
+        // Someone else changed the value since it was read
+        return false;
+    }
+
+    return this->set(*setting, value, std::move(args));
+}
+
+std::vector<rapidjson::Value *>
+SettingManager::getMany(const std::vector<std::string> &paths)
+{
+    return this->getManyImpl(paths);
+}
+
+std::vector<rapidjson::Value *>
+SettingManager::getMany(const std::vector<PathID> &paths)
+{
+    return this->getManyImpl(paths);
+}
+
+template <typename Paths>
+std::vector<rapidjson::Value *>
+SettingManager::getManyImpl(const Paths &paths)
+{
+    std::vector<rapidjson::Value *> values;
+    values.reserve(paths.size());
+
+    PathWalker walker(this->document, this->memberIndex);
+    for (const auto &path : paths) {
+        values.push_back(walker.walk(pathView(path)));
+    }
+
+    this->statistics->pointerResolutions.add(paths.size());
+
+    return values;
+}
+
+std::size_t
+SettingManager::setMany(
+    const std::vector<std::pair<std::string, rapidjson::Value>> &values,
+    SignalArgs args)
+{
+    return this->setManyImpl(values, std::move(args));
+}
+
+std::size_t
+SettingManager::setMany(
+    const std::vector<std::pair<PathID, rapidjson::Value>> &values,
+    SignalArgs args)
+{
+    return this->setManyImpl(values, std::move(args));
+}
+
+template <typename Values>
+std::size_t
+SettingManager::setManyImpl(const Values &values, SignalArgs args)
+{
+    if (this->isFrozen()) {
+        return 0;
+    }
+
+    Trace::Span span("setMany");
+    span.setCount(static_cast<std::int64_t>(values.size()));
+
+    std::vector<std::shared_ptr<SettingData>> settings;
+    settings.reserve(values.size());
+
+    {
+        std::lock_guard<std::mutex> lock(this->settingsMutex);
+
+        for (const auto &[path, value] : values) {
+            auto it = this->settings.find(pathView(path));
+            settings.push_back(it == this->settings.end() ? nullptr
+                                                          : it->second);
+        }
+    }
+
+    auto &allocator = this->document.GetAllocator();
+    PathWalker walker(this->document, this->memberIndex);
+
+    std::vector<std::size_t> changed;
+
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        const auto path = pathView(values[i].first);
+        const auto &value = values[i].second;
+
+        this->statistics->setCalls.add();
+
+        if (args.compareBeforeSet) {
+            this->statistics->pointerResolutions.add();
+            const auto *prevValue = walker.walk(path);
+            if (prevValue != nullptr && *prevValue == value) {
+                continue;
+            }
+        }
+
+        if (args.writeToFile) {
+            this->statistics->pointerResolutions.add();
+            auto *target = walker.walk(path, &allocator);
+            if (target == nullptr) {
+                // Invalid path
+                continue;
+            }
+            target->CopyFrom(value, allocator);
+        }
+
+        // The document now holds the newer value
+        if (settings[i] != nullptr) {
+            this->flatStorage->reload(this->document,
+                                      &settings[i]->getPointer());
+        } else if (!this->flatStorage->empty()) {
+            const rapidjson::Pointer pointer(
+                path.data(), static_cast<std::size_t>(path.size()));
+            this->flatStorage->reload(this->document, &pointer);
+        }
+
+        changed.push_back(i);
+    }
+
+    if (changed.empty()) {
+        return 0;
+    }
+
+    this->hasUnsavedChanges = true;
+
+    if (args.writeToFile &&
+        this->hasSaveMethodFlag(SaveMethod::SaveOnSettingChange)) {
+        this->save();
+    }
+
+    // Listeners only run once all values are in the document
+    detail::NotificationBatch batch;
+    for (auto i : changed) {
+        if (settings[i] != nullptr) {
+            this->notifyUpdate(*settings[i], values[i].second, args);
+        }
+    }
+
+    return changed.size();
+}
+
+bool
+SettingManager::set(SettingData &setting, const rapidjson::Value &value,
+                    SignalArgs args)
+{
+    return this->setImpl(setting.getPath(), setting.getPointer(), &setting,
+                         value, std::move(args));
+}
+
+bool
+SettingManager::setImpl(const std::string &path,
+                        const rapidjson::Pointer &pointer, SettingData *setting,
+                        const rapidjson::Value &value, SignalArgs args)
 {
     PS_DEBUG("sm::set('" << path << "'): " << internal::pp(value));
+
+    if (this->isFrozen()) {
+        PS_DEBUG("sm::set('" << path << "'): manager is frozen");
+        return false;
+    }
+
+    if (!pointer.IsValid()) {
+        PS_DEBUG("sm::set('" << path << "'): invalid path");
+        return false;
+    }
+
+    this->statistics->setCalls.add();
+
     if (args.compareBeforeSet) {
-        const auto *prevValue = rapidjson::Pointer(path).Get(this->document);
+        this->statistics->pointerResolutions.add();
+        const auto *prevValue =
+            resolvePointer(this->document, pointer, this->memberIndex);
         if (prevValue != nullptr && *prevValue == value) {
             return false;
         }
@@ -71,15 +580,155 @@ SettingManager::set(const std::string &path, const rapidjson::Value &value,
 
     if (args.writeToFile) {
         if (!args.resetToDefault) {
-            rapidjson::Pointer(path).Set(this->document, value);
+            this->statistics->pointerResolutions.add();
+            auto &allocator = this->document.GetAllocator();
+            auto *target = resolvePointer(this->document, pointer,
+                                          this->memberIndex, &allocator);
+            if (target != nullptr) {
+                target->CopyFrom(value, allocator);
+            }
         }
+    }
+
+    // The document now holds the newer value. Read before saving, so the
+    // save doesn't flush older FlatStorage values over it
+    this->flatStorage->reload(this->document, &pointer);
+
+    if (args.writeToFile &&
+        this->hasSaveMethodFlag(SaveMethod::SaveOnSettingChange)) {
+        this->save();
+    }
+
+    if (setting != nullptr) {
+        this->notifyUpdate(*setting, value, std::move(args));
+    }
+
+    return true;
+}
+
+bool
+SettingManager::setFlat(SettingData &setting, detail::FlatSlot &slot,
+                        std::uint64_t bits, SignalArgs args)
+{
+    if (this->isFrozen()) {
+        return false;
+    }
+
+    this->statistics->setCalls.add();
+
+    auto value = detail::FlatStorage::toJSON(slot.kind, bits);
 
-        if (this->hasSaveMethodFlag(SaveMethod::SaveOnSettingChange)) {
-            this->save();
+    PS_DEBUG("sm::setFlat('" << setting.getPath()
+                             << "'): " << internal::pp(value));
+
+    if (!this->flatStorage->store(slot, bits, args.compareBeforeSet)) {
+        return false;
+    }
+
+    this->hasUnsavedChanges = true;
+
+    if (this->hasSaveMethodFlag(SaveMethod::SaveOnSettingChange)) {
+        this->save();
+    }
+
+    this->notifyUpdate(setting, value, std::move(args));
+
+    return true;
+}
+
+bool
+SettingManager::setMember(SettingData &setting, std::string_view key,
+                          const rapidjson::Value &value, SignalArgs args)
+{
+    if (this->isFrozen()) {
+        return false;
+    }
+
+    this->statistics->setCalls.add();
+
+    const auto &pointer = setting.getPointer();
+    auto &allocator = this->document.GetAllocator();
+
+    this->statistics->pointerResolutions.add();
+    auto *object = resolvePointer(this->document, pointer, this->memberIndex,
+                                  &allocator);
+    if (object == nullptr) {
+        return false;
+    }
+
+    if (!object->IsObject()) {
+        object->SetObject();
+        // Anything that was below the old value is gone
+        this->invalidateDocumentCaches(pointer);
+    }
+
+    auto *member = this->memberIndex.find(*object, key);
+    if (member != nullptr) {
+        if (args.compareBeforeSet && *member == value) {
+            return false;
         }
+
+        member->CopyFrom(value, allocator);
+    } else {
+        object->AddMember(
+            rapidjson::Value(key.data(),
+                             static_cast<rapidjson::SizeType>(key.size()),
+                             allocator)
+                .Move(),
+            rapidjson::Value(value, allocator).Move(), allocator);
     }
 
-    this->notifyUpdate(path, value, std::move(args));
+    // Settings inside the member may have FlatStorage values
+    const auto memberPointer = pointer.Append(
+        key.data(), static_cast<rapidjson::SizeType>(key.size()));
+    this->flatStorage->reload(this->document, &memberPointer);
+    this->hasUnsavedChanges = true;
+
+    if (this->hasSaveMethodFlag(SaveMethod::SaveOnSettingChange)) {
+        this->save();
+    }
+
+    args.change = SignalArgs::Change::MemberAssigned;
+    args.key = key;
+
+    this->notifyUpdate(setting, *object, std::move(args));
+
+    return true;
+}
+
+bool
+SettingManager::eraseMember(SettingData &setting, std::string_view key,
+                            SignalArgs args)
+{
+    if (this->isFrozen()) {
+        return false;
+    }
+
+    this->statistics->setCalls.add();
+
+    const auto &pointer = setting.getPointer();
+    auto *object = this->get(pointer);
+    if (object == nullptr || !object->IsObject()) {
+        return false;
+    }
+
+    if (!this->memberIndex.remove(*object, key)) {
+        return false;
+    }
+
+    const auto memberPointer = pointer.Append(
+        key.data(), static_cast<rapidjson::SizeType>(key.size()));
+    this->flatStorage->reload(this->document, &memberPointer);
+    this->hasUnsavedChanges = true;
+
+    if (this->hasSaveMethodFlag(SaveMethod::SaveOnSettingChange)) {
+        this->save();
+    }
+
+    args.change = SignalArgs::Change::MemberErased;
+    args.key = key;
+
+    this->notifyUpdate(setting, *object, std::move(args));
 
     return true;
 }
@@ -93,7 +742,19 @@ SettingManager::notifyUpdate(const std::string &path,
         return;
     }
 
-    setting->notifyUpdate(value, std::move(args));
+    this->notifyUpdate(*setting, value, std::move(args));
+}
+
+void
+SettingManager::notifyUpdate(SettingData &setting,
+                             const rapidjson::Value &value, SignalArgs args)
+{
+    args.pathID = setting.getPathID();
+
+    detail::StatTimer timer;
+    setting.notifyUpdate(value, std::move(args));
+    this->statistics->notificationsFired.add();
+    this->statistics->listenerTime.record(timer.elapsed());
 }
 
 void
@@ -106,8 +767,11 @@ SettingManager::notifyLoadedValues()
 
     this->settingsMutex.unlock();
 
+    Trace::Span span("notifyLoadedValues");
+    span.setCount(static_cast<std::int64_t>(loadedSettings.size()));
+
     for (const auto &it : loadedSettings) {
-        auto *v = this->get(it.first);
+        auto *v = this->get(it.second->getPointer());
         if (v == nullptr) {
             continue;
         }
@@ -116,7 +780,7 @@ SettingManager::notifyLoadedValues()
         SignalArgs args;
         args.source = SignalArgs::Source::Setter;
 
-        it.second->notifyUpdate(*v, std::move(args));
+        this->notifyUpdate(*it.second, *v, std::move(args));
     }
 }
 
@@ -170,7 +834,14 @@ SettingManager::setNull(const std::string &path)
 {
     const auto &instance = SettingManager::getInstance();
 
-    rapidjson::Pointer(path).Set(instance->document, rapidjson::Value());
+    if (instance->isFrozen()) {
+        return;
+    }
+
+    const rapidjson::Pointer pointer(path);
+    pointer.Set(instance->document, rapidjson::Value());
+
+    instance->invalidateDocumentCaches(pointer);
 }
 
 bool
@@ -179,7 +850,9 @@ SettingManager::removeArrayValue(const std::string &arrayPath,
 {
     const auto &instance = SettingManager::getInstance();
 
-    instance->clearSettings(arrayPath + "/" + std::to_string(index) + "/");
+    if (instance->isFrozen()) {
+        return false;
+    }
 
     rapidjson::SizeType size = SettingManager::arraySize(arrayPath);
 
@@ -203,37 +876,353 @@ SettingManager::removeArrayValue(const std::string &arrayPath,
     if (index == size - 1) {
         // We want to remove the last element
         array.PopBack();
+        instance->invalidateDocumentCaches(rapidjson::Pointer(
+            arrayPath + "/" + std::to_string(index)));
     } else {
         SettingManager::setNull(arrayPath + "/" + std::to_string(index));
     }
 
-    instance->clearSettings(arrayPath + "/" + std::to_string(index) + "/");
+    instance->clearSettings(arrayPath + "/" + std::to_string(index) + "/");
+
+    return true;
+}
+
+rapidjson::SizeType
+SettingManager::cleanArray(const std::string &arrayPath)
+{
+    if (SettingManager::getInstance()->isFrozen()) {
+        return 0;
+    }
+
+    rapidjson::SizeType size = SettingManager::arraySize(arrayPath);
+
+    if (size == 0) {
+        // No values to remove
+        return 0;
+    }
+
+    const auto &instance = SettingManager::getInstance();
+
+    rapidjson::SizeType numValuesRemoved = 0;
+
+    for (rapidjson::SizeType i = size - 1; i > 0; --i) {
+        if (instance->_isNull(arrayPath + "/" + std::to_string(i))) {
+            SettingManager::removeArrayValue(arrayPath, i);
+            ++numValuesRemoved;
+        }
+    }
+
+    return numValuesRemoved;
+}
+
+rapidjson::SizeType
+SettingManager::compactArray(
+    const std::string &arrayPath,
+    const std::function<bool(const rapidjson::Value &)> &predicate)
+{
+    if (this->isFrozen()) {
+        return 0;
+    }
+
+    const rapidjson::Pointer arrayPointer(arrayPath);
+
+    // The predicate must see the values of FlatStorage settings in the array
+    if (this->flatStorage->flush(this->document, &arrayPointer) > 0) {
+        this->memberIndex.clear();
+    }
+
+    auto *valuePointer = arrayPointer.Get(this->document);
+    if (valuePointer == nullptr || !valuePointer->IsArray()) {
+        return 0;
+    }
+
+    rapidjson::Value &array = *valuePointer;
+    const auto size = array.Size();
+
+    // Move the kept elements to the front, remembering where each one went
+    std::vector<rapidjson::SizeType> newIndices(size);
+    rapidjson::SizeType kept = 0;
+    for (rapidjson::SizeType i = 0; i < size; ++i) {
+        if (predicate(array[i])) {
+            newIndices[i] = rapidjson::kPointerInvalidIndex;
+            continue;
+        }
+
+        if (kept != i) {
+            array[kept].Swap(array[i]);
+        }
+        newIndices[i] = kept++;
+    }
+
+    if (kept == size) {
+        return 0;
+    }
+
+    while (array.Size() > kept) {
+        array.PopBack();
+    }
+
+    this->arrayElementsMoved(arrayPath, array, newIndices, SignalArgs());
+
+    return size - kept;
+}
+
+bool
+SettingManager::insertArrayValue(const std::string &arrayPath,
+                                 rapidjson::SizeType index,
+                                 const rapidjson::Value &value)
+{
+    return this->insertArrayValue(arrayPath, rapidjson::Pointer(arrayPath),
+                                  index, value, SignalArgs());
+}
+
+bool
+SettingManager::insertArrayValue(const std::string &arrayPath,
+                                 const rapidjson::Pointer &arrayPointer,
+                                 rapidjson::SizeType index,
+                                 const rapidjson::Value &value,
+                                 SignalArgs args)
+{
+    if (this->isFrozen()) {
+        return false;
+    }
+
+    this->statistics->setCalls.add();
+
+    this->statistics->pointerResolutions.add();
+    auto *valuePointer =
+        resolvePointer(this->document, arrayPointer, this->memberIndex);
+    if (valuePointer == nullptr || !valuePointer->IsArray()) {
+        return false;
+    }
+
+    rapidjson::Value &array = *valuePointer;
+    const auto size = array.Size();
+
+    if (index > size) {
+        // Index out of bounds
+        return false;
+    }
+
+    const auto *elements = array.Begin();
+
+    auto &allocator = this->document.GetAllocator();
+    array.PushBack(rapidjson::Value(value, allocator).Move(), allocator);
+
+    if (array.Begin() != elements) {
+        // The elements were reallocated, objects among them have new addresses
+        this->memberIndex.clear();
+    }
+
+    // Bubble the new value down to its index
+    for (auto i = size; i > index; --i) {
+        array[i].Swap(array[i - 1]);
+    }
+
+    // Appending doesn't move any elements
+    std::vector<rapidjson::SizeType> newIndices;
+    if (index < size) {
+        newIndices.resize(size);
+        for (rapidjson::SizeType i = 0; i < size; ++i) {
+            newIndices[i] = i < index ? i : i + 1;
+        }
+    }
+
+    args.change = SignalArgs::Change::ElementInserted;
+    args.index = index;
+
+    this->arrayElementsMoved(arrayPath, array, newIndices, std::move(args));
+
+    return true;
+}
+
+bool
+SettingManager::eraseArrayValue(const std::string &arrayPath,
+                                rapidjson::SizeType index)
+{
+    return this->eraseArrayValue(arrayPath, rapidjson::Pointer(arrayPath),
+                                 index, SignalArgs());
+}
+
+bool
+SettingManager::eraseArrayValue(const std::string &arrayPath,
+                                const rapidjson::Pointer &arrayPointer,
+                                rapidjson::SizeType index, SignalArgs args)
+{
+    if (this->isFrozen()) {
+        return false;
+    }
+
+    this->statistics->setCalls.add();
+
+    this->statistics->pointerResolutions.add();
+    auto *valuePointer =
+        resolvePointer(this->document, arrayPointer, this->memberIndex);
+    if (valuePointer == nullptr || !valuePointer->IsArray()) {
+        return false;
+    }
+
+    rapidjson::Value &array = *valuePointer;
+    const auto size = array.Size();
+
+    if (index >= size) {
+        // Index out of bounds
+        return false;
+    }
+
+    for (auto i = index; i + 1 < size; ++i) {
+        array[i].Swap(array[i + 1]);
+    }
+    array.PopBack();
+
+    std::vector<rapidjson::SizeType> newIndices(size);
+    for (rapidjson::SizeType i = 0; i < size; ++i) {
+        if (i < index) {
+            newIndices[i] = i;
+        } else if (i == index) {
+            newIndices[i] = rapidjson::kPointerInvalidIndex;
+        } else {
+            newIndices[i] = i - 1;
+        }
+    }
+
+    args.change = SignalArgs::Change::ElementErased;
+    args.index = index;
+
+    this->arrayElementsMoved(arrayPath, array, newIndices, std::move(args));
+
+    return true;
+}
+
+bool
+SettingManager::moveArrayValue(const std::string &arrayPath,
+                               rapidjson::SizeType from, rapidjson::SizeType to)
+{
+    if (this->isFrozen()) {
+        return false;
+    }
+
+    auto *valuePointer = rapidjson::Pointer(arrayPath).Get(this->document);
+    if (valuePointer == nullptr || !valuePointer->IsArray()) {
+        return false;
+    }
+
+    rapidjson::Value &array = *valuePointer;
+    const auto size = array.Size();
+
+    if (from >= size || to >= size) {
+        // Index out of bounds
+        return false;
+    }
+
+    if (from == to) {
+        return true;
+    }
+
+    std::vector<rapidjson::SizeType> newIndices(size);
+    for (rapidjson::SizeType i = 0; i < size; ++i) {
+        newIndices[i] = i;
+    }
+
+    // Shift the elements between the two indices by one towards `from`
+    if (from < to) {
+        for (auto i = from; i < to; ++i) {
+            array[i].Swap(array[i + 1]);
+            newIndices[i + 1] = i;
+        }
+    } else {
+        for (auto i = from; i > to; --i) {
+            array[i].Swap(array[i - 1]);
+            newIndices[i - 1] = i;
+        }
+    }
+    newIndices[from] = to;
+
+    this->arrayElementsMoved(arrayPath, array, newIndices, SignalArgs());
+
+    return true;
+}
+
+void
+SettingManager::arrayElementsMoved(
+    const std::string &arrayPath, const rapidjson::Value &array,
+    const std::vector<rapidjson::SizeType> &newIndices, SignalArgs args)
+{
+    // FlatStorage slots follow their settings to the new indices
+    if (!newIndices.empty()) {
+        this->memberIndex.clear();
+    }
+    this->hasUnsavedChanges = true;
+
+    auto arraySetting = this->remapArrayElements(arrayPath, newIndices);
+
+    if (this->hasSaveMethodFlag(SaveMethod::SaveOnSettingChange)) {
+        this->save();
+    }
+
+    if (arraySetting) {
+        if (args.source == SignalArgs::Source::Unset) {
+            args.source = SignalArgs::Source::Setter;
+        }
 
-    return true;
+        this->notifyUpdate(*arraySetting, array, std::move(args));
+    }
 }
 
-rapidjson::SizeType
-SettingManager::cleanArray(const std::string &arrayPath)
+std::shared_ptr<SettingData>
+SettingManager::remapArrayElements(
+    const std::string &arrayPath,
+    const std::vector<rapidjson::SizeType> &newIndices)
 {
-    rapidjson::SizeType size = SettingManager::arraySize(arrayPath);
+    const auto prefix = arrayPath + "/";
 
-    if (size == 0) {
-        // No values to remove
-        return 0;
-    }
+    std::vector<std::pair<std::shared_ptr<SettingData>, PathID>> moved;
 
-    const auto &instance = SettingManager::getInstance();
+    std::lock_guard<std::mutex> lock(this->settingsMutex);
 
-    rapidjson::SizeType numValuesRemoved = 0;
+    // Children of the array are next to each other in the registry
+    auto it = this->settings.lower_bound(std::string_view(prefix));
+    while (it != this->settings.end() && it->first.starts_with(prefix)) {
+        auto rest = it->first.substr(prefix.size());
+        auto tokenEnd = std::min(rest.find('/'), rest.size());
+        auto index = detail::tokenIndex(rest.substr(0, tokenEnd));
 
-    for (rapidjson::SizeType i = size - 1; i > 0; --i) {
-        if (instance->_isNull(arrayPath + "/" + std::to_string(i))) {
-            SettingManager::removeArrayValue(arrayPath, i);
-            ++numValuesRemoved;
+        if (index == rapidjson::kPointerInvalidIndex ||
+            index >= newIndices.size() || newIndices[index] == index) {
+            ++it;
+            continue;
         }
+
+        if (newIndices[index] != rapidjson::kPointerInvalidIndex) {
+            auto newPath = prefix + std::to_string(newIndices[index]);
+            newPath += rest.substr(tokenEnd);
+            moved.emplace_back(it->second, PathID::intern(newPath));
+        }
+
+        it = this->settings.erase(it);
     }
 
-    return numValuesRemoved;
+    // Every old index maps to its own new index, so the moved settings can't
+    // collide with each other. They can land on a setting past the end of the
+    // array though, which has no value to keep, so it's removed like an
+    // erased element and its handles are invalidated
+    for (auto &[setting, newPath] : moved) {
+        setting->relocate(newPath);
+        auto [stale, inserted] =
+            this->settings.try_emplace(newPath.view(), setting);
+        if (!inserted) {
+            this->settings.erase(stale);
+            this->settings.emplace(newPath.view(), std::move(setting));
+        }
+        newPath.release();
+    }
+
+    auto arraySetting = this->settings.find(std::string_view(arrayPath));
+    if (arraySetting == this->settings.end()) {
+        return nullptr;
+    }
+
+    return arraySetting->second;
 }
 
 std::vector<std::string>
@@ -249,18 +1238,44 @@ SettingManager::getObjectKeys(const std::string &objectPath,
 {
     std::vector<std::string> ret;
 
-    auto *root = instance->get(objectPath);
+    instance->forEachObjectKey(objectPath, [&ret](std::string_view key) {
+        ret.emplace_back(key);
+    });
+
+    return ret;
+}
+
+bool
+SettingManager::forEachObjectKey(
+    const std::string &objectPath,
+    const std::function<void(std::string_view)> &callback)
+{
+    return this->forEachObjectMember(
+        objectPath,
+        [&callback](std::string_view key, const rapidjson::Value & /*value*/) {
+            callback(key);
+        });
+}
+
+bool
+SettingManager::forEachObjectMember(
+    const std::string &objectPath,
+    const std::function<void(std::string_view, const rapidjson::Value &)>
+        &callback)
+{
+    const auto *root = this->get(objectPath);
 
     if (root == nullptr || !root->IsObject()) {
-        return ret;
+        return false;
     }
 
-    for (rapidjson::Value::ConstMemberIterator it = root->MemberBegin();
-         it != root->MemberEnd(); ++it) {
-        ret.emplace_back(it->name.GetString());
+    for (auto it = root->MemberBegin(); it != root->MemberEnd(); ++it) {
+        callback(std::string_view(it->name.GetString(),
+                                  it->name.GetStringLength()),
+                 it->value);
     }
 
-    return ret;
+    return true;
 }
 
 void
@@ -268,8 +1283,13 @@ SettingManager::clear()
 {
     const auto &instance = SettingManager::getInstance();
 
+    if (instance->isFrozen()) {
+        return;
+    }
+
     // Clear document
     rapidjson::Value(rapidjson::kObjectType).Swap(instance->document);
+    instance->invalidateDocumentCaches();
 
     // Clear map of settings
     std::lock_guard<std::mutex> lock(instance->settingsMutex);
@@ -294,8 +1314,15 @@ SettingManager::removeSetting(const std::string &path)
 bool
 SettingManager::removeSettingSoft(const std::string &path)
 {
+    if (this->isFrozen()) {
+        return false;
+    }
+
     auto ptr = rapidjson::Pointer(path);
 
+    // FlatStorage values inside the path are removed along with the rest
+    this->flatStorage->flush(this->document, &ptr);
+
     std::lock_guard<std::mutex> lock(this->settingsMutex);
 
     std::string pathWithExtendor;
@@ -311,20 +1338,31 @@ SettingManager::removeSettingSoft(const std::string &path)
         const auto &p = *iter;
         if (p.first.compare(0, pathWithExtendor.length(), pathWithExtendor) ==
             0) {
-            rapidjson::Pointer(p.first).Erase(this->document);
+            rapidjson::Pointer(p.second->getPath()).Erase(this->document);
         } else {
             ++iter;
         }
     }
 
-    return ptr.Erase(this->document);
+    auto removed = ptr.Erase(this->document);
+
+    this->invalidateDocumentCaches(ptr);
+
+    return removed;
 }
 
 bool
 SettingManager::_removeSetting(const std::string &path)
 {
+    if (this->isFrozen()) {
+        return false;
+    }
+
     auto ptr = rapidjson::Pointer(path);
 
+    // FlatStorage values inside the path are removed along with the rest
+    this->flatStorage->flush(this->document, &ptr);
+
     std::lock_guard<std::mutex> lock(this->settingsMutex);
 
     this->settings.erase(path);
@@ -342,14 +1380,18 @@ SettingManager::_removeSetting(const std::string &path)
         const auto &p = *iter;
         if (p.first.compare(0, pathWithExtendor.length(), pathWithExtendor) ==
             0) {
-            rapidjson::Pointer(p.first).Erase(this->document);
+            rapidjson::Pointer(p.second->getPath()).Erase(this->document);
             this->settings.erase(iter++);
         } else {
             ++iter;
         }
     }
 
-    return ptr.Erase(this->document);
+    auto removed = ptr.Erase(this->document);
+
+    this->invalidateDocumentCaches(ptr);
+
+    return removed;
 }
 
 void
@@ -357,7 +1399,7 @@ SettingManager::clearSettings(const std::string &root)
 {
     std::lock_guard<std::mutex> lock(this->settingsMutex);
 
-    std::vector<std::string> keysToBeRemoved;
+    std::vector<std::string_view> keysToBeRemoved;
 
     for (const auto &setting : this->settings) {
         if (setting.first.compare(0, root.length(), root) == 0) {
@@ -406,6 +1448,21 @@ SettingManager::load(const std::filesystem::path &path,
 SettingManager::LoadError
 SettingManager::loadFrom(const std::filesystem::path &path,
                          std::optional<LoadOptions> overrideLoadOptions)
+{
+    if (this->isFrozen()) {
+        return LoadError::Frozen;
+    }
+
+    detail::StatTimer timer;
+    auto result = this->loadFromImpl(path, overrideLoadOptions);
+    this->statistics->loadDuration.record(timer.elapsed());
+
+    return result;
+}
+
+SettingManager::LoadError
+SettingManager::loadFromImpl(const std::filesystem::path &path,
+                             std::optional<LoadOptions> overrideLoadOptions)
 {
     auto result = this->readFrom(path);
 
@@ -419,21 +1476,7 @@ SettingManager::loadFrom(const std::filesystem::path &path,
 
             auto tmpResult = this->readFrom(tmpPath);
             if (tmpResult == LoadError::NoError) {
-                if (!this->writeTo(path)) {
-                    return LoadError::SavingFromTemporaryFileFailed;
-                }
-
-                // The "settings.json.tmp" file was successfully read and saved to "settings.json"
-                std::error_code ec;
-                std::filesystem::remove(tmpPath, ec);
-                if (ec) {
-                    // The setting path is in a bad state,
-                    // but we have successfully loaded from the .tmp file, and saved that content to settings.json.
-                    //
-                    // Next time the user saves, they will most likely get a save error because they couldn't save to
-                    // the .tmp file. This is best handled there.
-                    return LoadError::NoError;
-                }
+                return this->finishLoadFromTemporaryFile(path, tmpPath);
             }
 
             return tmpResult;
@@ -443,6 +1486,131 @@ SettingManager::loadFrom(const std::filesystem::path &path,
     return result;
 }
 
+std::future<SettingManager::LoadError>
+SettingManager::loadAsync(const std::filesystem::path &path, Executor executor,
+                          std::optional<LoadOptions> overrideLoadOptions)
+{
+    // Like load, the given path becomes the default path. It's only assigned
+    // when the document is swapped in, on the thread that uses the manager
+    auto filePath = path.empty() ? this->filePath : path;
+
+    auto options = overrideLoadOptions.value_or(this->loadOptions);
+
+    // Without an owning std::shared_ptr, every load would be Cancelled
+    assert(!this->weak_from_this().expired());
+
+    if (!executor) {
+        executor = [pendingLoads =
+                        this->pendingLoads](std::function<void()> task) {
+            std::unique_lock lock(pendingLoads->mutex);
+            if (!pendingLoads->closed) {
+                pendingLoads->tasks.push_back(std::move(task));
+                return;
+            }
+            lock.unlock();
+
+            task();
+        };
+    }
+
+    // The task is stored in a std::function, which must be copyable
+    auto promise = std::make_shared<std::promise<LoadError>>();
+    auto future = promise->get_future();
+
+    std::thread([weakSelf = this->weak_from_this(), filePath,
+                 setPath = !path.empty(), options,
+                 executor = std::move(executor), promise] {
+        detail::StatTimer parseTimer;
+        auto parsed = std::make_shared<rapidjson::Document>();
+
+        auto loadedPath = filePath;
+        auto result = SettingManager::parseFile(loadedPath, *parsed);
+
+        if (result != LoadError::NoError &&
+            options.attemptLoadFromTemporaryFile) {
+            // Loading from initial settings file failed, attempt to load from temporary file
+            loadedPath += ".tmp";
+            result = SettingManager::parseFile(loadedPath, *parsed);
+        }
+
+        auto parseDuration = parseTimer.elapsed();
+
+        auto apply = [weakSelf, filePath, setPath, loadedPath, result,
+                           parsed, parseDuration] {
+            auto self = weakSelf.lock();
+            if (!self) {
+                return LoadError::Cancelled;
+            }
+
+            if (setPath) {
+                self->filePath = filePath;
+            }
+
+            if (self->isFrozen()) {
+                return LoadError::Frozen;
+            }
+
+            detail::StatTimer applyTimer;
+            auto finalResult = result;
+
+            if (result == LoadError::NoError) {
+                self->applyParsedDocument(*parsed);
+
+                if (loadedPath != filePath) {
+                    finalResult = self->finishLoadFromTemporaryFile(
+                        filePath, loadedPath);
+                }
+            }
+
+            self->statistics->loadDuration.record(parseDuration +
+                                                  applyTimer.elapsed());
+            return finalResult;
+        };
+
+        executor([apply = std::move(apply), promise] {
+            promise->set_value(apply());
+        });
+    }).detach();
+
+    return future;
+}
+
+std::size_t
+SettingManager::applyPendingLoads()
+{
+    std::vector<std::function<void()>> tasks;
+    {
+        std::unique_lock lock(this->pendingLoads->mutex);
+        tasks.swap(this->pendingLoads->tasks);
+    }
+
+    for (auto &task : tasks) {
+        task();
+    }
+
+    return tasks.size();
+}
+
+SettingManager::LoadError
+SettingManager::finishLoadFromTemporaryFile(
+    const std::filesystem::path &path, const std::filesystem::path &tmpPath)
+{
+    if (!this->writeTo(path)) {
+        return LoadError::SavingFromTemporaryFileFailed;
+    }
+
+    // The "settings.json.tmp" file was successfully read and saved to "settings.json"
+    std::error_code ec;
+    std::filesystem::remove(tmpPath, ec);
+
+    // If removing the .tmp file failed, the setting path is in a bad state,
+    // but we have successfully loaded from the .tmp file, and saved that content to settings.json.
+    //
+    // Next time the user saves, they will most likely get a save error because they couldn't save to
+    // the .tmp file. This is best handled there.
+    return LoadError::NoError;
+}
+
 SettingManager::SaveResult
 SettingManager::gSave(const std::filesystem::path &path)
 {
@@ -475,36 +1643,91 @@ SettingManager::saveAs(const std::filesystem::path &path)
     PS_DEBUG("sm::saveAs('" << path << "'): saving '"
                             << internal::pp(this->document) << '\'');
 
+    this->statistics->savesAttempted.add();
+
     if (this->hasSaveMethodFlag(SaveMethod::OnlySaveIfChanged) &&
         !this->hasUnsavedChanges) {
         PS_DEBUG("sm::saveAs('"
                  << path << "'): skipping save, OnlySaveIfChanged is set");
         // No save necessary - no changes have been made
+        this->statistics->savesSkipped.add();
         return SaveResult::Skipped;
     }
 
+    Trace::Span span("saveAs");
+    span.setDetail(path.string());
+
+    detail::StatTimer saveTimer;
+    std::chrono::nanoseconds writeDuration{};
+
     std::error_code ec;
     Backup::saveWithBackup(
         path, this->backup,
-        [this](const auto &tmpPath, auto &ec) {
+        [this, &writeDuration](const auto &tmpPath, auto &ec) {
+            detail::StatTimer writeTimer;
             if (!this->writeTo(tmpPath)) {
                 ec = std::make_error_code(std::errc::io_error);
             } else {
                 this->hasUnsavedChanges = false;
             }
+            writeDuration = writeTimer.elapsed();
         },
         ec);
 
+    auto saveDuration = saveTimer.elapsed();
+    this->statistics->saveDuration.record(saveDuration);
+
     if (ec) {
+        this->statistics->savesFailed.add();
         return SaveResult::Failed;
     }
 
+    if (this->backup.enabled) {
+        // Everything that's not writing the file is backup rotation & renaming
+        this->statistics->backupRotationTime.record(saveDuration -
+                                                    writeDuration);
+    }
+
     return SaveResult::Success;
 }
 
+std::size_t
+SettingManager::flushFlatStorage()
+{
+    auto flushed = this->flatStorage->flush(this->document);
+    if (flushed > 0) {
+        // Flushed values might have added members to indexed objects
+        this->memberIndex.clear();
+    }
+
+    return flushed;
+}
+
+void
+SettingManager::setMemberIndexThreshold(std::size_t threshold)
+{
+    this->memberIndex.setThreshold(threshold);
+}
+
+void
+SettingManager::invalidateDocumentCaches()
+{
+    this->flatStorage->reload(this->document);
+    this->memberIndex.clear();
+}
+
+void
+SettingManager::invalidateDocumentCaches(const rapidjson::Pointer &changed)
+{
+    this->flatStorage->reload(this->document, &changed);
+    this->memberIndex.clear();
+}
+
 bool
 SettingManager::writeTo(const std::filesystem::path &path)
 {
+    this->flushFlatStorage();
+
     std::ofstream fh(path, std::ios::binary | std::ios::out);
     if (!fh) {
         // Unable to open file at `path`
@@ -512,16 +1735,43 @@ SettingManager::writeTo(const std::filesystem::path &path)
     }
 
     rapidjson::StringBuffer buffer;
-    rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(buffer);
-    this->document.Accept(writer);
+    {
+        Trace::Span span("serialize");
+        rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(buffer);
+        this->document.Accept(writer);
+    }
 
-    fh.write(buffer.GetString(), buffer.GetSize());
+    {
+        Trace::Span span("write");
+        span.setCount(static_cast<std::int64_t>(buffer.GetSize()));
+        fh.write(buffer.GetString(), buffer.GetSize());
+    }
+    this->statistics->bytesWritten.add(buffer.GetSize());
 
     return true;
 }
 
 SettingManager::LoadError
 SettingManager::readFrom(const std::filesystem::path &_path)
+{
+    Trace::Span span("readFrom");
+    span.setDetail(_path.string());
+
+    rapidjson::Document parsed;
+
+    auto result = SettingManager::parseFile(_path, parsed);
+    if (result != LoadError::NoError) {
+        return result;
+    }
+
+    this->applyParsedDocument(parsed);
+
+    return LoadError::NoError;
+}
+
+SettingManager::LoadError
+SettingManager::parseFile(const std::filesystem::path &_path,
+                          rapidjson::Document &parsed)
 {
     std::error_code ec;
 
@@ -535,6 +1785,7 @@ SettingManager::readFrom(const std::filesystem::path &_path)
     std::ostringstream fileBufferStream;
 
     {
+        Trace::Span span("read");
         std::ifstream fh(path, std::ios::binary | std::ios::in);
         if (!fh) {
             // Unable to open file at `path`
@@ -549,10 +1800,10 @@ SettingManager::readFrom(const std::filesystem::path &_path)
         return LoadError::NoError;
     }
 
-    // Merge newly parsed config file into our pre-existing document
-    // The pre-existing document might be empty, but we don't know that
+    Trace::Span span("parse");
+    span.setCount(static_cast<std::int64_t>(fileBuffer.size()));
 
-    rapidjson::ParseResult ok = this->document.Parse(fileBuffer);
+    rapidjson::ParseResult ok = parsed.Parse(fileBuffer);
 
     // Make sure the file parsed okay
     if (!ok) {
@@ -560,16 +1811,31 @@ SettingManager::readFrom(const std::filesystem::path &_path)
     }
 
     // This restricts config files a bit. They NEED to have an object root
-    if (!this->document.IsObject()) {
+    // Checked before the document is swapped in, so a bad file doesn't
+    // replace the currently loaded document
+    if (!parsed.IsObject()) {
         return LoadError::JSONParseError;
     }
 
+    return LoadError::NoError;
+}
+
+void
+SettingManager::applyParsedDocument(rapidjson::Document &parsed)
+{
+    if (parsed.IsNull()) {
+        // The file was empty
+        return;
+    }
+
+    // The newly parsed config file replaces our pre-existing document
+    this->document.Swap(parsed);
+    this->invalidateDocumentCaches();
+
     // Perform deep merge of objects
     // detail::mergeObjects(document, d, document.GetAllocator());
 
     this->notifyLoadedValues();
-
-    return LoadError::NoError;
 }
 
 void
@@ -584,6 +1850,83 @@ SettingManager::setBackupSlots(uint8_t numSlots)
     this->backup.numSlots = numSlots;
 }
 
+Stats
+SettingManager::stats() const
+{
+    return this->statistics->snapshot();
+}
+
+ListenerProfiler &
+SettingManager::listenerProfiler()
+{
+    return *this->profiler;
+}
+
+void
+SettingManager::freeze()
+{
+    this->flushFlatStorage();
+
+    std::lock_guard<std::mutex> lock(this->settingsMutex);
+
+    if (this->isFrozen()) {
+        return;
+    }
+
+    this->frozenRegistry.build(this->settings);
+
+    // Readers only look at the table after seeing the flag
+    this->frozen->store(true, std::memory_order_release);
+}
+
+bool
+SettingManager::isFrozen() const
+{
+    return this->frozen->load(std::memory_order_acquire);
+}
+
+MemoryUsage
+SettingManager::memoryUsage()
+{
+    MemoryUsage usage;
+
+    const auto &allocator = this->document.GetAllocator();
+    usage.allocatorUsed = allocator.Size();
+    usage.allocatorCapacity = allocator.Capacity();
+
+    // The root value lives in the Document itself, not in the pool
+    usage.liveBytes = estimatePoolBytes(this->document);
+    if (usage.allocatorUsed > 0) {
+        usage.liveRatio = static_cast<double>(usage.liveBytes) /
+                          static_cast<double>(usage.allocatorUsed);
+    }
+
+    if (this->document.IsObject()) {
+        for (auto it = this->document.MemberBegin();
+             it != this->document.MemberEnd(); ++it) {
+            usage.topLevel.push_back({
+                .key = {it->name.GetString(), it->name.GetStringLength()},
+                .bytes = memberSize + estimateStringBytes(it->name) +
+                         estimatePoolBytes(it->value),
+            });
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(this->settingsMutex);
+
+    const auto &pathTable = PathTable::instance();
+    usage.internedPaths = pathTable.size();
+    usage.internedPathBytes = pathTable.bytes();
+
+    usage.settingCount = this->settings.size();
+    for (const auto &[path, setting] : this->settings) {
+        usage.settingPathBytes += path.size();
+        usage.listenerCount += setting->getListenerCount();
+    }
+
+    return usage;
+}
+
 const std::shared_ptr<SettingManager> &
 SettingManager::getInstance()
 {
@@ -595,21 +1938,144 @@ SettingManager::getInstance()
 std::weak_ptr<SettingData>
 SettingManager::getSetting(const std::string &path,
                            std::shared_ptr<SettingManager> instance)
+{
+    return SettingManager::getSettingHandle(path, std::move(instance));
+}
+
+detail::SettingDataHandle
+SettingManager::getSettingHandle(const std::string &path,
+                                 std::shared_ptr<SettingManager> instance)
+{
+    auto id = PathID::intern(path);
+    auto handle = SettingManager::getSettingHandle(id, std::move(instance));
+    id.release();
+
+    return handle;
+}
+
+detail::SettingDataHandle
+SettingManager::getSettingHandle(PathID path,
+                                 std::shared_ptr<SettingManager> instance)
+{
+    if (!instance) {
+        instance = SettingManager::getInstance();
+    }
+
+    if (instance->isFrozen()) {
+        // The registry can't grow anymore, unknown paths get an invalid handle
+        const auto *setting = instance->frozenRegistry.find(path.view());
+        return detail::SettingDataHandle(setting != nullptr ? *setting
+                                                            : nullptr);
+    }
+
+    std::lock_guard<std::mutex> lock(instance->settingsMutex);
+
+    return detail::SettingDataHandle(
+        instance->findOrCreateSetting(path, instance));
+}
+
+detail::SettingDataHandle
+SettingManager::getSettingHandle(const detail::KeyBinding &key,
+                                 std::shared_ptr<SettingManager> instance)
 {
     if (!instance) {
         instance = SettingManager::getInstance();
     }
 
+    if (instance->isFrozen()) {
+        const auto *setting = instance->frozenRegistry.find(key.path.view());
+        return detail::SettingDataHandle(setting != nullptr ? *setting
+                                                            : nullptr);
+    }
+
     std::lock_guard<std::mutex> lock(instance->settingsMutex);
 
-    auto &setting = instance->settings[path];
+    auto &slots = instance->keySlots;
+    if (key.slot < slots.size()) {
+        auto setting = slots[key.slot].lock();
+        // The setting may have followed its array element to another index
+        if (setting && setting->getPathID() == key.path) {
+            return detail::SettingDataHandle(setting);
+        }
+    } else {
+        slots.resize(key.slot + 1);
+    }
+
+    // First use of the key in this manager, or the registry dropped its setting
+    const auto &setting =
+        instance->findOrCreateSetting(key.path, instance, key.pointer);
+    slots[key.slot] = setting;
+
+    return detail::SettingDataHandle(setting);
+}
+
+const std::shared_ptr<SettingData> &
+SettingManager::findOrCreateSetting(PathID path,
+                                    const std::shared_ptr<SettingManager> &self,
+                                    const rapidjson::Pointer *pointer)
+{
+    auto &setting = this->settings[path.view()];
 
     if (setting == nullptr) {
         // No setting has been created with this path
-        setting.reset(new SettingData(path, instance));
+        setting.reset(new SettingData(path, self, pointer));
+    }
+
+    return setting;
+}
+
+std::size_t
+SettingManager::compactRegistry(std::size_t budget)
+{
+    if (this->isFrozen()) {
+        return 0;
+    }
+
+    std::lock_guard<std::mutex> lock(this->settingsMutex);
+
+    if (budget == 0 || budget > this->settings.size()) {
+        budget = this->settings.size();
+        this->compactCursor.clear();
+    }
+
+    std::size_t removed = 0;
+
+    auto it = this->settings.lower_bound(this->compactCursor);
+    for (std::size_t inspected = 0;
+         inspected < budget && !this->settings.empty(); ++inspected) {
+        if (it == this->settings.end()) {
+            it = this->settings.begin();
+        }
+
+        const auto &setting = it->second;
+
+        // A FlatStorage value that hasn't been flushed yet would be lost
+        const auto *slot = setting->flatSlot.load(std::memory_order_acquire);
+        const auto unflushed =
+            slot != nullptr && slot->state.load(std::memory_order_acquire) ==
+                                   detail::FlatSlot::State::Dirty;
+
+        // New handles are only created while settingsMutex is held, and
+        // copies of a handle can't be made without one existing already.
+        // Other strong references (an awaiter, a notification in progress)
+        // show up in the use count.
+        if (setting->getHandleCount() == 0 &&
+            setting->getListenerCount() == 0 && setting.use_count() == 1 &&
+            !unflushed) {
+            it = this->settings.erase(it);
+            ++removed;
+        } else {
+            ++it;
+        }
+    }
+
+    if (it == this->settings.end()) {
+        this->compactCursor.clear();
+    } else {
+        this->compactCursor = it->first;
     }
 
-    return std::static_pointer_cast<SettingData>(setting);
+    return removed;
 }
 
 std::shared_ptr<SettingData>
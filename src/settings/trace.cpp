@@ -0,0 +1,174 @@
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+
+#include <functional>
+#include <pajlada/settings/trace.hpp>
+#include <utility>
+
+namespace pajlada::Settings::Trace {
+
+namespace detail {
+
+std::atomic<bool> enabled{false};
+
+}  // namespace detail
+
+namespace {
+
+std::mutex sinkMutex;
+std::shared_ptr<Sink> currentSink;
+
+}  // namespace
+
+void
+setSink(std::shared_ptr<Sink> sink)
+{
+    std::lock_guard lock(sinkMutex);
+
+    detail::enabled.store(sink != nullptr, std::memory_order_relaxed);
+    currentSink = std::move(sink);
+}
+
+std::shared_ptr<Sink>
+getSink()
+{
+    if (!isEnabled()) {
+        return nullptr;
+    }
+
+    std::lock_guard lock(sinkMutex);
+
+    return currentSink;
+}
+
+void
+instant(std::string_view name, std::string detail, std::string_view category)
+{
+    auto sink = getSink();
+    if (!sink) {
+        return;
+    }
+
+    Event event;
+    event.type = Event::Type::Instant;
+    event.name = name;
+    event.category = category;
+    event.start = std::chrono::steady_clock::now();
+    event.thread = std::this_thread::get_id();
+    event.detail = std::move(detail);
+
+    sink->write(event);
+}
+
+Span::Span(std::string_view name, std::string_view category)
+    : sink(getSink())
+{
+    if (!this->sink) {
+        return;
+    }
+
+    this->event.name = name;
+    this->event.category = category;
+    this->event.thread = std::this_thread::get_id();
+    this->event.start = std::chrono::steady_clock::now();
+}
+
+Span::~Span()
+{
+    if (!this->sink) {
+        return;
+    }
+
+    this->event.duration =
+        std::chrono::steady_clock::now() - this->event.start;
+    this->sink->write(this->event);
+}
+
+ChromeTraceSink::ChromeTraceSink(const std::filesystem::path &path)
+    : fh(path, std::ios::binary | std::ios::out | std::ios::trunc)
+    , epoch(std::chrono::steady_clock::now())
+{
+    this->fh << "[\n";
+}
+
+ChromeTraceSink::~ChromeTraceSink()
+{
+    std::lock_guard lock(this->mutex);
+
+    this->fh << "\n]\n";
+}
+
+bool
+ChromeTraceSink::isOpen() const
+{
+    return this->fh.is_open();
+}
+
+void
+ChromeTraceSink::write(const Event &event)
+{
+    using Microseconds = std::chrono::duration<double, std::micro>;
+
+    rapidjson::StringBuffer buffer;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+
+    writer.StartObject();
+    writer.Key("name");
+    writer.String(event.name.data(),
+                  static_cast<rapidjson::SizeType>(event.name.size()));
+    writer.Key("cat");
+    writer.String(event.category.data(),
+                  static_cast<rapidjson::SizeType>(event.category.size()));
+    writer.Key("ph");
+    if (event.type == Event::Type::Span) {
+        writer.String("X");
+        writer.Key("dur");
+        writer.Double(Microseconds(event.duration).count());
+    } else {
+        writer.String("i");
+        writer.Key("s");
+        writer.String("t");
+    }
+    writer.Key("ts");
+    writer.Double(Microseconds(event.start - this->epoch).count());
+    writer.Key("pid");
+    writer.Int(1);
+    writer.Key("tid");
+    // The trace viewers want a number, the actual value doesn't matter
+    writer.Uint(static_cast<std::uint32_t>(
+        std::hash<std::thread::id>{}(event.thread)));
+
+    if (!event.detail.empty() || event.count >= 0) {
+        writer.Key("args");
+        writer.StartObject();
+        if (!event.detail.empty()) {
+            writer.Key("detail");
+            writer.String(event.detail);
+        }
+        if (event.count >= 0) {
+            writer.Key("count");
+            writer.Int64(event.count);
+        }
+        writer.EndObject();
+    }
+    writer.EndObject();
+
+    std::lock_guard lock(this->mutex);
+
+    if (!this->first) {
+        this->fh << ",\n";
+    }
+    this->first = false;
+    this->fh.write(buffer.GetString(),
+                   static_cast<std::streamsize>(buffer.GetSize()));
+}
+
+void
+ChromeTraceSink::flush()
+{
+    std::lock_guard lock(this->mutex);
+
+    this->fh.flush();
+}
+
+}  // namespace pajlada::Settings::Trace
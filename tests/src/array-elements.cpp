@@ -0,0 +1,288 @@
+#include <gtest/gtest.h>
+
+#include <pajlada/settings.hpp>
+#include <string>
+#include <vector>
+
+using namespace pajlada::Settings;
+using SaveMethod = SettingManager::SaveMethod;
+
+namespace {
+
+std::shared_ptr<SettingManager>
+makeList(const std::string &path, const std::vector<std::string> &names)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    for (std::size_t i = 0; i < names.size(); ++i) {
+        sm->set(path + "/" + std::to_string(i) + "/name",
+                rapidjson::Value(names[i].c_str(), sm->document.GetAllocator()));
+    }
+
+    return sm;
+}
+
+}  // namespace
+
+TEST(ArrayElements, Insert)
+{
+    auto sm = makeList("/elements/insert", {"a", "b"});
+
+    Setting<std::string> a("/elements/insert/0/name", sm);
+    Setting<std::string> b("/elements/insert/1/name", sm);
+
+    rapidjson::Value value(rapidjson::kObjectType);
+    value.AddMember(rapidjson::Value("name"), rapidjson::Value("new"),
+                    sm->document.GetAllocator());
+
+    EXPECT_TRUE(sm->insertArrayValue("/elements/insert", 1, value));
+    EXPECT_EQ(SettingManager::arraySize("/elements/insert", sm), 3);
+
+    EXPECT_EQ(a.getPath(), "/elements/insert/0/name");
+    EXPECT_EQ(a.getValue(), "a");
+    EXPECT_EQ(b.getPath(), "/elements/insert/2/name");
+    EXPECT_EQ(b.getValue(), "b");
+
+    Setting<std::string> inserted("/elements/insert/1/name", sm);
+    EXPECT_EQ(inserted.getValue(), "new");
+
+    // Appending
+    EXPECT_TRUE(sm->insertArrayValue("/elements/insert", 3, value));
+    EXPECT_FALSE(sm->insertArrayValue("/elements/insert", 5, value));
+    EXPECT_EQ(SettingManager::arraySize("/elements/insert", sm), 4);
+    EXPECT_FALSE(sm->insertArrayValue("/elements/missing", 0, value));
+}
+
+TEST(ArrayElements, Erase)
+{
+    auto sm = makeList("/elements/erase", {"a", "b", "c"});
+
+    Setting<std::string> a("/elements/erase/0/name", sm);
+    Setting<std::string> b("/elements/erase/1/name", sm);
+    Setting<std::string> c("/elements/erase/2/name", sm);
+
+    int cCount = 0;
+    c.connect(
+        [&](const std::string &) {
+            ++cCount;
+        },
+        false);
+
+    EXPECT_TRUE(sm->eraseArrayValue("/elements/erase", 1));
+    EXPECT_FALSE(sm->eraseArrayValue("/elements/erase", 2));
+    EXPECT_EQ(SettingManager::arraySize("/elements/erase", sm), 2);
+
+    EXPECT_EQ(a.getValue(), "a");
+    EXPECT_FALSE(b.isValid());
+    EXPECT_EQ(c.getPath(), "/elements/erase/1/name");
+    EXPECT_EQ(c.getValue(), "c");
+
+    // Writes through the moved setting go to its new index
+    c = "c2";
+    EXPECT_EQ(cCount, 1);
+    EXPECT_STREQ(sm->get("/elements/erase/1/name")->GetString(), "c2");
+    EXPECT_EQ(sm->get("/elements/erase/2"), nullptr);
+}
+
+TEST(ArrayElements, Move)
+{
+    auto sm = makeList("/elements/move", {"a", "b", "c", "d"});
+
+    std::vector<Setting<std::string>> names;
+    for (int i = 0; i < 4; ++i) {
+        names.emplace_back("/elements/move/" + std::to_string(i) + "/name",
+                           sm);
+    }
+
+    EXPECT_TRUE(sm->moveArrayValue("/elements/move", 0, 2));
+    EXPECT_EQ(names[0].getPath(), "/elements/move/2/name");
+    EXPECT_EQ(names[1].getPath(), "/elements/move/0/name");
+    EXPECT_EQ(names[2].getPath(), "/elements/move/1/name");
+    EXPECT_EQ(names[3].getPath(), "/elements/move/3/name");
+
+    EXPECT_TRUE(sm->moveArrayValue("/elements/move", 3, 0));
+    EXPECT_EQ(names[0].getPath(), "/elements/move/3/name");
+    EXPECT_EQ(names[1].getPath(), "/elements/move/1/name");
+    EXPECT_EQ(names[2].getPath(), "/elements/move/2/name");
+    EXPECT_EQ(names[3].getPath(), "/elements/move/0/name");
+
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_EQ(names[i].getValue(), std::string(1, 'a' + i));
+    }
+
+    Setting<std::string> first("/elements/move/0/name", sm);
+    EXPECT_EQ(first.getValue(), "d");
+
+    EXPECT_FALSE(sm->moveArrayValue("/elements/move", 0, 4));
+}
+
+TEST(ArrayElements, InsertOverSettingPastEnd)
+{
+    auto sm = makeList("/elements/past", {"a", "b"});
+
+    Setting<std::string> b("/elements/past/1/name", sm);
+    Setting<std::string> past("/elements/past/2/name", sm);
+    EXPECT_TRUE(past.isValid());
+
+    rapidjson::Value value(rapidjson::kObjectType);
+    value.AddMember(rapidjson::Value("name"), rapidjson::Value("new"),
+                    sm->document.GetAllocator());
+
+    EXPECT_TRUE(sm->insertArrayValue("/elements/past", 0, value));
+
+    // b moved onto the path of the setting past the end, which is removed
+    EXPECT_EQ(b.getPath(), "/elements/past/2/name");
+    EXPECT_EQ(b.getValue(), "b");
+    EXPECT_FALSE(past.isValid());
+
+    // Only one setting is left at the path
+    Setting<std::string> again("/elements/past/2/name", sm);
+    EXPECT_EQ(again.getValue(), "b");
+    again.setValue("c");
+    EXPECT_EQ(b.getValue(), "c");
+}
+
+TEST(ArrayElements, Keys)
+{
+    constexpr Key<"/elements/key/0/name", std::string> firstName;
+
+    auto sm = makeList("/elements/key", {"a"});
+
+    Setting<std::string> a(firstName, sm);
+    EXPECT_TRUE(sm->insertArrayValue("/elements/key", 0,
+                                     rapidjson::Value(rapidjson::kObjectType)));
+    EXPECT_EQ(a.getPath(), "/elements/key/1/name");
+    EXPECT_EQ(a.getValue(), "a");
+
+    // The key doesn't follow the setting it was bound to
+    Setting<std::string> b(firstName, sm);
+    EXPECT_EQ(b.getPath(), "/elements/key/0/name");
+    EXPECT_EQ(b.getValue(), "");
+}
+
+TEST(ArrayElements, SettingPushBack)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    Setting<std::vector<int>> list("/elements/pushback", sm);
+
+    std::vector<SignalArgs::Change> changes;
+    std::vector<std::size_t> indices;
+    list.connect(
+        [&](const std::vector<int> &, const SignalArgs &args) {
+            changes.push_back(args.change);
+            indices.push_back(args.index);
+        },
+        false);
+
+    // Unset, so the whole value is set
+    list.push_back(1);
+    list.push_back(2);
+    list.push_back(3);
+
+    EXPECT_EQ(list.getValue(), (std::vector<int>{1, 2, 3}));
+    EXPECT_EQ(SettingManager::arraySize("/elements/pushback", sm), 3);
+
+    ASSERT_EQ(changes.size(), 3);
+    EXPECT_EQ(changes[0], SignalArgs::Change::Value);
+    EXPECT_EQ(changes[1], SignalArgs::Change::ElementInserted);
+    EXPECT_EQ(indices[1], 1);
+    EXPECT_EQ(changes[2], SignalArgs::Change::ElementInserted);
+    EXPECT_EQ(indices[2], 2);
+
+    Setting<std::vector<int>> other("/elements/pushback", sm);
+    EXPECT_EQ(other.getValue(), (std::vector<int>{1, 2, 3}));
+}
+
+TEST(ArrayElements, SettingPushBackIgnoresDefault)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    Setting<std::vector<int>> list("/elements/pushback-default",
+                                   std::vector<int>{7, 8}, sm);
+
+    // An unset container starts out empty, like it did before
+    list.push_back(1);
+    EXPECT_EQ(list.getValue(), (std::vector<int>{1}));
+}
+
+TEST(ArrayElements, SettingPushBackNotAnArray)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    Setting<std::vector<int>> list("/elements/not-an-array", sm);
+    list = std::vector<int>{1};
+
+    // Replaced behind the Setting's back
+    rapidjson::Value object(rapidjson::kObjectType);
+    ASSERT_TRUE(sm->set("/elements/not-an-array", object));
+
+    // The element can't be inserted in place, so the whole value is written
+    list.push_back(2);
+    EXPECT_EQ(SettingManager::arraySize("/elements/not-an-array", sm), 1);
+
+    Setting<std::vector<int>> other("/elements/not-an-array", sm);
+    EXPECT_EQ(other.getValue(), (std::vector<int>{2}));
+}
+
+TEST(ArrayElements, SettingPushBackNotAnArrayCompareBeforeSet)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    Setting<std::vector<int>> list("/elements/not-an-array-compare",
+                                   SettingOption::CompareBeforeSet, sm);
+    list = std::vector<int>{1};
+
+    // Replaced without notifying, so the cached value is still {1}
+    rapidjson::Pointer("/elements/not-an-array-compare")
+        .Set(sm->document, rapidjson::Value(5));
+    sm->invalidateDocumentCaches();
+
+    // The cached value already holds the new element when the whole value is
+    // written, that must not count as unchanged
+    list.push_back(2);
+    EXPECT_EQ(SettingManager::arraySize("/elements/not-an-array-compare", sm),
+              2);
+    EXPECT_EQ(list.getValue(), (std::vector<int>{1, 2}));
+}
+
+TEST(ArrayElements, SettingInsertAndRemove)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    Setting<std::vector<std::string>> list("/elements/setting", sm);
+    list = std::vector<std::string>{"a", "c"};
+
+    Setting<std::string> c("/elements/setting/1", sm);
+    EXPECT_EQ(c.getValue(), "c");
+
+    EXPECT_TRUE(list.insert(1, "b"));
+    EXPECT_FALSE(list.insert(4, "x"));
+    EXPECT_EQ(list.getValue(), (std::vector<std::string>{"a", "b", "c"}));
+
+    // Element settings follow their element
+    EXPECT_EQ(c.getPath(), "/elements/setting/2");
+    EXPECT_EQ(c.getValue(), "c");
+
+    EXPECT_TRUE(list.removeAt(0));
+    EXPECT_FALSE(list.removeAt(2));
+    EXPECT_EQ(list.getValue(), (std::vector<std::string>{"b", "c"}));
+    EXPECT_EQ(c.getPath(), "/elements/setting/1");
+
+    list.removeByValue("b");
+    EXPECT_EQ(list.getValue(), (std::vector<std::string>{"c"}));
+
+    list.push_back("c");
+    list.push_back("d");
+    list.removeByValue("c");
+    EXPECT_EQ(list.getValue(), (std::vector<std::string>{"d"}));
+
+    Setting<std::vector<std::string>> other("/elements/setting", sm);
+    EXPECT_EQ(other.getValue(), (std::vector<std::string>{"d"}));
+}
@@ -0,0 +1,183 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <pajlada/settings.hpp>
+#include <pajlada/settings/atomicsetting.hpp>
+#include <thread>
+
+using namespace pajlada::Settings;
+using SaveMethod = SettingManager::SaveMethod;
+
+namespace {
+
+constexpr Key<"/atomic/key/a", bool> keyA;
+
+}  // namespace
+
+TEST(AtomicSetting, ReadWrite)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    AtomicSetting<int> a("/atomic/rw/a", 3, sm);
+
+    EXPECT_EQ(a.getPath(), "/atomic/rw/a");
+    EXPECT_EQ(a.getValue(), 3);
+
+    a = 5;
+    EXPECT_EQ(a.getValue(), 5);
+
+    EXPECT_EQ(sm->flushFlatStorage(), 1);
+    const auto *value = sm->get("/atomic/rw/a");
+    ASSERT_NE(value, nullptr);
+    EXPECT_EQ(value->GetInt(), 5);
+
+    a.resetToDefaultValue();
+    EXPECT_EQ(a.getValue(), 3);
+    EXPECT_EQ(sm->get("/atomic/rw/a"), nullptr);
+}
+
+TEST(AtomicSetting, SharedWithSetting)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    AtomicSetting<bool> a(keyA, sm);
+    AtomicSetting<bool> b("/atomic/key/a", sm);
+    Setting<bool> flat(keyA, SettingOption::FlatStorage, sm);
+    Setting<bool> regular(keyA, sm);
+
+    int count = 0;
+    regular.connect([&count] { ++count; }, false);
+
+    a = true;
+    EXPECT_TRUE(b.getValue());
+    EXPECT_TRUE(flat.getValue());
+    EXPECT_TRUE(regular.getValue());
+    EXPECT_EQ(count, 1);
+
+    regular = false;
+    EXPECT_FALSE(a.getValue());
+    EXPECT_FALSE(b.getValue());
+    EXPECT_EQ(count, 2);
+
+    flat = true;
+    EXPECT_TRUE(a);
+}
+
+TEST(AtomicSetting, DifferentKind)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    Setting<double> flat("/atomic/kind/a", SettingOption::FlatStorage, sm);
+    flat = 2.0;
+
+    AtomicSetting<int> a("/atomic/kind/a", sm);
+    EXPECT_EQ(a.getValue(), 2);
+
+    a = 4;
+    EXPECT_EQ(flat.getValue(), 4.0);
+}
+
+TEST(AtomicSetting, KeepsSettingRegistered)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    AtomicSetting<int> a("/atomic/compact/a", sm);
+    a = 5;
+
+    EXPECT_EQ(sm->compactRegistry(), 0);
+    EXPECT_EQ(a.getValue(), 5);
+}
+
+TEST(AtomicSetting, ConcurrentReads)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    AtomicSetting<int> a("/atomic/threads/a", sm);
+    a = 0;
+    EXPECT_EQ(a.getValue(), 0);
+
+    std::atomic<bool> done{false};
+    int last = 0;
+    bool increasing = true;
+
+    std::thread reader([&] {
+        while (!done) {
+            auto value = a.getValue();
+            if (value < last) {
+                increasing = false;
+            }
+            last = value;
+        }
+    });
+
+    for (int i = 1; i <= 1000; ++i) {
+        a = i;
+    }
+
+    done = true;
+    reader.join();
+
+    EXPECT_TRUE(increasing);
+    EXPECT_EQ(a.getValue(), 1000);
+}
+
+TEST(AtomicSetting, DocumentWrites)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    AtomicSetting<int> a("/atomic/document/a", 3, sm);
+    AtomicSetting<int> b("/atomic/document/b", 4, sm);
+
+    sm->set("/atomic/document/a", rapidjson::Value(5));
+    EXPECT_EQ(a.getValue(), 5);
+    EXPECT_EQ(b.getValue(), 4);
+
+    rapidjson::Document object(rapidjson::kObjectType);
+    object.AddMember("b", rapidjson::Value(6).Move(), object.GetAllocator());
+    sm->set("/atomic/document", object);
+    EXPECT_EQ(a.getValue(), 3);
+    EXPECT_EQ(b.getValue(), 6);
+
+    EXPECT_TRUE(sm->removeSetting("/atomic/document/b"));
+    EXPECT_EQ(b.getValue(), 4);
+}
+
+TEST(AtomicSetting, ConcurrentDocumentWrites)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    AtomicSetting<int> a("/atomic/document-threads/a", sm);
+
+    std::atomic<bool> done{false};
+    int last = 0;
+    bool increasing = true;
+
+    // Writes through the document refill the slot, the reader never reads
+    // the document while it's being written to
+    std::thread reader([&] {
+        while (!done) {
+            auto value = a.getValue();
+            if (value < last) {
+                increasing = false;
+            }
+            last = value;
+        }
+    });
+
+    for (int i = 1; i <= 1000; ++i) {
+        sm->set("/atomic/document-threads/a", rapidjson::Value(i));
+    }
+
+    done = true;
+    reader.join();
+
+    EXPECT_TRUE(increasing);
+    EXPECT_EQ(a.getValue(), 1000);
+}
@@ -0,0 +1,227 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <pajlada/settings.hpp>
+#include <pajlada/settings/coalescingsettinglistener.hpp>
+#include <thread>
+
+using namespace pajlada::Settings;
+using namespace pajlada;
+using SaveMethod = SettingManager::SaveMethod;
+
+using namespace std::chrono_literals;
+
+TEST(CoalescingListener, immediate)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    Setting<int> a("/coalescing/immediate/a", sm);
+    Setting<int> b("/coalescing/immediate/b", sm);
+
+    std::vector<std::vector<std::string>> batches;
+    CoalescingSettingListener listener(
+        [&](const std::vector<std::string> &paths) {
+            batches.push_back(paths);
+        });
+
+    listener.addSetting(a);
+    listener.addSetting(b);
+    ASSERT_TRUE(batches.empty());
+
+    a = 1;
+    ASSERT_EQ(batches.size(), 1);
+    EXPECT_EQ(batches[0], std::vector<std::string>{a.getPath()});
+
+    b = 1;
+    ASSERT_EQ(batches.size(), 2);
+    EXPECT_EQ(batches[1], std::vector<std::string>{b.getPath()});
+}
+
+TEST(CoalescingListener, transaction)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    Setting<int> a("/coalescing/transaction/a", sm);
+    Setting<int> b("/coalescing/transaction/b", sm);
+    Setting<int> c("/coalescing/transaction/c", sm);
+
+    std::vector<std::vector<std::string>> batches;
+    CoalescingSettingListener listener(
+        [&](const std::vector<std::string> &paths) {
+            batches.push_back(paths);
+        });
+
+    listener.addSetting(a);
+    listener.addSetting(b);
+    listener.addSetting(c);
+
+    {
+        auto outer = listener.transaction();
+        a = 1;
+        b = 1;
+        {
+            auto inner = listener.transaction();
+            a = 2;
+            c = 1;
+        }
+        // The inner transaction ending must not deliver the batch
+        ASSERT_TRUE(batches.empty());
+    }
+
+    ASSERT_EQ(batches.size(), 1);
+    std::vector<std::string> expected{a.getPath(), b.getPath(), c.getPath()};
+    EXPECT_EQ(batches[0], expected);
+
+    {
+        auto t = listener.transaction();
+    }
+    // Empty transactions don't invoke the callback
+    ASSERT_EQ(batches.size(), 1);
+}
+
+TEST(CoalescingListener, explicitFlush)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    Setting<int> a("/coalescing/explicit-flush/a", sm);
+    Setting<int> b("/coalescing/explicit-flush/b", sm);
+
+    std::vector<std::vector<std::string>> batches;
+    CoalescingSettingListener listener(
+        [&](const std::vector<std::string> &paths) {
+            batches.push_back(paths);
+        },
+        1h);
+
+    listener.addSetting(a);
+    listener.addSetting(b);
+
+    a = 1;
+    b = 1;
+    a = 2;
+    ASSERT_TRUE(batches.empty());
+
+    listener.flush();
+    ASSERT_EQ(batches.size(), 1);
+    std::vector<std::string> expected{a.getPath(), b.getPath()};
+    EXPECT_EQ(batches[0], expected);
+
+    listener.flush();
+    ASSERT_EQ(batches.size(), 1);
+}
+
+TEST(CoalescingListener, window)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    Setting<int> a("/coalescing/window/a", sm);
+    Setting<int> b("/coalescing/window/b", sm);
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<std::vector<std::string>> batches;
+    CoalescingSettingListener listener(
+        [&](const std::vector<std::string> &paths) {
+            std::unique_lock lock(mutex);
+            batches.push_back(paths);
+            cv.notify_all();
+        },
+        200ms);
+
+    listener.addSetting(a);
+    listener.addSetting(b);
+
+    a = 1;
+    b = 1;
+
+    std::unique_lock lock(mutex);
+    ASSERT_TRUE(cv.wait_for(lock, 5s, [&] {
+        return !batches.empty();
+    }));
+    ASSERT_EQ(batches.size(), 1);
+    std::vector<std::string> expected{a.getPath(), b.getPath()};
+    EXPECT_EQ(batches[0], expected);
+}
+
+TEST(CoalescingListener, changeFromCallback)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    Setting<int> a("/coalescing/change-from-callback/a", sm);
+    Setting<int> b("/coalescing/change-from-callback/b", sm);
+
+    std::vector<std::vector<std::string>> batches;
+    CoalescingSettingListener listener;
+    listener.setCB([&](const std::vector<std::string> &paths) {
+        batches.push_back(paths);
+        if (batches.size() == 1) {
+            b = 5;
+        }
+    });
+
+    listener.addSetting(a);
+    listener.addSetting(b);
+
+    a = 1;
+
+    ASSERT_EQ(batches.size(), 2);
+    EXPECT_EQ(batches[0], std::vector<std::string>{a.getPath()});
+    EXPECT_EQ(batches[1], std::vector<std::string>{b.getPath()});
+}
+
+TEST(CoalescingListener, flushWaitsForOtherThread)
+{
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool inCallback = false;
+    bool release = false;
+    std::vector<std::string> delivered;
+
+    CoalescingSettingListener listener(
+        [&](const std::vector<std::string> &paths) {
+            std::unique_lock<std::mutex> lock(mutex);
+            inCallback = true;
+            cv.notify_all();
+            cv.wait(lock, [&] {
+                return release;
+            });
+            delivered.insert(delivered.end(), paths.begin(), paths.end());
+        });
+
+    std::thread first([&] {
+        listener.markChanged("/coalescing/wait/a");
+    });
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [&] {
+            return inCallback;
+        });
+    }
+
+    std::thread releaser([&] {
+        std::this_thread::sleep_for(50ms);
+        std::unique_lock<std::mutex> lock(mutex);
+        release = true;
+        cv.notify_all();
+    });
+
+    // Returns once the other thread has delivered our change too
+    listener.markChanged("/coalescing/wait/b");
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        EXPECT_EQ(delivered, (std::vector<std::string>{"/coalescing/wait/a",
+                                                       "/coalescing/wait/b"}));
+    }
+
+    first.join();
+    releaser.join();
+}
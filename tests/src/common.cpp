@@ -161,3 +161,14 @@ RJStringify(const rapidjson::Value &v)
 
     return {buffer.GetString()};
 }
+
+SettingManager::LoadError
+WaitForLoad(SettingManager &sm, std::future<SettingManager::LoadError> future)
+{
+    while (future.wait_for(std::chrono::milliseconds(1)) !=
+           std::future_status::ready) {
+        sm.applyPendingLoads();
+    }
+
+    return future.get();
+}
@@ -5,6 +5,7 @@
 #include <rapidjson/rapidjson.h>
 
 #include <filesystem>
+#include <future>
 #include <memory>
 #include <pajlada/serialize/common.hpp>
 #include <pajlada/serialize/deserialize.hpp>
@@ -43,6 +44,11 @@ void RJPrettyPrint(const std::shared_ptr<pajlada::Settings::SettingManager> &sm,
                    const std::string &prefix = {});
 std::string RJStringify(const rapidjson::Value &v);
 
+/// Apply the manager's pending loads until the given loadAsync future is ready
+pajlada::Settings::SettingManager::LoadError WaitForLoad(
+    pajlada::Settings::SettingManager &sm,
+    std::future<pajlada::Settings::SettingManager::LoadError> future);
+
 #ifdef PAJLADA_SETTINGS_ENABLE_EXCEPTIONS
 #define DD_THROWS(x) REQUIRE_THROWS(x)
 #define REQUIRE_IF_NOEXCEPT(x, y)
@@ -0,0 +1,160 @@
+#include <gtest/gtest.h>
+#include <rapidjson/pointer.h>
+
+#include <optional>
+#include <pajlada/settings.hpp>
+#include <string>
+#include <vector>
+
+using namespace pajlada::Settings;
+using SaveMethod = SettingManager::SaveMethod;
+
+namespace {
+
+bool
+isNull(const rapidjson::Value &value)
+{
+    return value.IsNull();
+}
+
+void
+setArray(SettingManager &sm, const std::string &path,
+         const std::vector<std::optional<int>> &values)
+{
+    rapidjson::Value array(rapidjson::kArrayType);
+    for (const auto &value : values) {
+        array.PushBack(value ? rapidjson::Value(*value) : rapidjson::Value(),
+                       sm.document.GetAllocator());
+    }
+    sm.set(path, array);
+}
+
+}  // namespace
+
+TEST(CompactArray, RemovesMatchingElements)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    Setting<std::vector<int>> array("/compact/remove", sm);
+    setArray(*sm, "/compact/remove",
+             {std::nullopt, 1, std::nullopt, 2, 3, std::nullopt});
+
+    EXPECT_EQ(sm->compactArray("/compact/remove", isNull), 3);
+    EXPECT_EQ(array.getValue(), (std::vector<int>{1, 2, 3}));
+
+    EXPECT_EQ(sm->compactArray("/compact/remove", isNull), 0);
+
+    EXPECT_EQ(sm->compactArray("/compact/remove",
+                               [](const rapidjson::Value &value) {
+                                   return value.GetInt() % 2 == 1;
+                               }),
+              2);
+    EXPECT_EQ(array.getValue(), (std::vector<int>{2}));
+}
+
+TEST(CompactArray, NotAnArray)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    Setting<int> a("/compact/object/a", sm);
+    a = 5;
+
+    EXPECT_EQ(sm->compactArray("/compact/object", isNull), 0);
+    EXPECT_EQ(sm->compactArray("/compact/missing", isNull), 0);
+    EXPECT_EQ(a.getValue(), 5);
+}
+
+TEST(CompactArray, SettingsFollowTheirElement)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    sm->set("/compact/follow/0/name", rapidjson::Value("a"));
+    sm->set("/compact/follow/1", rapidjson::Value());
+    sm->set("/compact/follow/2/name", rapidjson::Value("c"));
+    sm->set("/compact/follow/3/name", rapidjson::Value("d"));
+
+    Setting<std::string> a("/compact/follow/0/name", sm);
+    Setting<std::string> removed("/compact/follow/1/name", sm);
+    Setting<std::string> c("/compact/follow/2/name", sm);
+    Setting<std::string> d("/compact/follow/3/name", sm);
+
+    int cCount = 0;
+    c.connect(
+        [&](const std::string &) {
+            ++cCount;
+        },
+        false);
+
+    EXPECT_EQ(sm->compactArray("/compact/follow", isNull), 1);
+
+    EXPECT_EQ(a.getPath(), "/compact/follow/0/name");
+    EXPECT_EQ(a.getValue(), "a");
+
+    EXPECT_FALSE(removed.isValid());
+
+    EXPECT_EQ(c.getPath(), "/compact/follow/1/name");
+    EXPECT_EQ(c.getValue(), "c");
+    EXPECT_EQ(d.getPath(), "/compact/follow/2/name");
+    EXPECT_EQ(d.getValue(), "d");
+
+    // New settings at the index share the moved setting
+    Setting<std::string> c2("/compact/follow/1/name", sm);
+    c2 = "c2";
+    EXPECT_EQ(c.getValue(), "c2");
+    EXPECT_EQ(cCount, 1);
+
+    Setting<std::string> d2("/compact/follow/3/name", sm);
+    EXPECT_EQ(d2.getValue(), "");
+}
+
+TEST(CompactArray, NotifiesArraySetting)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    Setting<std::vector<int>> array("/compact/notify", sm);
+    setArray(*sm, "/compact/notify", {1, std::nullopt, 2});
+
+    std::vector<std::vector<int>> values;
+    array.connect(
+        [&](const std::vector<int> &value) {
+            values.push_back(value);
+        },
+        false);
+
+    EXPECT_EQ(sm->compactArray("/compact/notify", isNull), 1);
+    ASSERT_EQ(values.size(), 1);
+    EXPECT_EQ(values[0], (std::vector<int>{1, 2}));
+}
+
+TEST(CompactArray, CleanArray)
+{
+    auto sm = SettingManager::getInstance();
+
+    Setting<std::vector<int>> array("/compact/clean");
+    setArray(*sm, "/compact/clean",
+             {std::nullopt, 1, std::nullopt, 2, std::nullopt});
+
+    // Unchanged by compactArray: trailing nulls are popped, other nulls
+    // after the first element are counted but stay where they are
+    EXPECT_EQ(SettingManager::cleanArray("/compact/clean"), 2);
+    EXPECT_EQ(SettingManager::arraySize("/compact/clean", sm), 4);
+    EXPECT_TRUE(sm->get("/compact/clean/0")->IsNull());
+    EXPECT_TRUE(sm->get("/compact/clean/2")->IsNull());
+    EXPECT_EQ(sm->get("/compact/clean/3")->GetInt(), 2);
+}
+
+TEST(CompactArray, Frozen)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    setArray(*sm, "/compact/frozen", {1, std::nullopt});
+    sm->freeze();
+
+    EXPECT_EQ(sm->compactArray("/compact/frozen", isNull), 0);
+    EXPECT_EQ(SettingManager::arraySize("/compact/frozen", sm), 2);
+}
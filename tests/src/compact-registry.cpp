@@ -0,0 +1,147 @@
+#include <gtest/gtest.h>
+
+#include <pajlada/settings.hpp>
+#include <pajlada/settings/settinglistener.hpp>
+
+using namespace pajlada::Settings;
+using SaveMethod = SettingManager::SaveMethod;
+
+TEST(CompactRegistry, DropsUnused)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    {
+        Setting<int> a("/compact/unused/a", sm);
+        a = 5;
+    }
+
+    Setting<int> b("/compact/unused/b", sm);
+    b = 6;
+
+    EXPECT_EQ(sm->memoryUsage().settingCount, 2);
+    EXPECT_EQ(sm->compactRegistry(), 1);
+    EXPECT_EQ(sm->memoryUsage().settingCount, 1);
+
+    EXPECT_TRUE(b.isValid());
+    EXPECT_EQ(b.getValue(), 6);
+
+    // The value stays in the document & a new Setting registers again
+    Setting<int> a("/compact/unused/a", sm);
+    EXPECT_TRUE(a.isValid());
+    EXPECT_EQ(a.getValue(), 5);
+    EXPECT_EQ(sm->memoryUsage().settingCount, 2);
+
+    a = 7;
+    EXPECT_EQ(a.getValue(), 7);
+}
+
+TEST(CompactRegistry, KeepsCopies)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    auto copy = [&] {
+        Setting<int> a("/compact/copies/a", sm);
+        return std::make_unique<Setting<int>>(a);
+    }();
+
+    EXPECT_EQ(sm->compactRegistry(), 0);
+    EXPECT_TRUE(copy->isValid());
+
+    copy.reset();
+    EXPECT_EQ(sm->compactRegistry(), 1);
+}
+
+TEST(CompactRegistry, KeepsListeners)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    int calls = 0;
+    std::vector<pajlada::Signals::ScopedConnection> connections;
+
+    {
+        Setting<int> a("/compact/listeners/a", sm);
+        a.connect(
+            [&](int) {
+                ++calls;
+            },
+            connections, false);
+    }
+
+    // The Setting is gone but its listener is still connected
+    EXPECT_EQ(sm->compactRegistry(), 0);
+
+    Setting<int>::set("/compact/listeners/a", 1, sm);
+    EXPECT_EQ(calls, 1);
+}
+
+TEST(CompactRegistry, KeepsHandles)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    int calls = 0;
+    std::vector<pajlada::Signals::ScopedConnection> connections;
+
+    {
+        auto data = SettingManager::getSettingHandle("/compact/handles/a", sm);
+        EXPECT_EQ(sm->compactRegistry(), 0);
+
+        connections.emplace_back(data.lock()->connect(
+            [&](const rapidjson::Value &, const SignalArgs &) {
+                ++calls;
+            }));
+    }
+
+    // The handle is gone, the listener connected through it is still counted
+    EXPECT_EQ(sm->compactRegistry(), 0);
+
+    Setting<int>::set("/compact/handles/a", 1, sm);
+    EXPECT_EQ(calls, 1);
+}
+
+TEST(CompactRegistry, WeakData)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    Setting<int> a("/compact/weak/a", sm);
+
+    // getData & getSetting still hand out weak pointers, they don't count
+    std::weak_ptr<SettingData> data = a.getData();
+    std::weak_ptr<SettingData> same =
+        SettingManager::getSetting("/compact/weak/a", sm);
+    EXPECT_EQ(data.lock(), same.lock());
+
+    int calls = 0;
+    pajlada::Signals::ScopedConnection connection(data.lock()->updated.connect(
+        [&](const rapidjson::Value &, const SignalArgs &) {
+            ++calls;
+        }));
+
+    a = 1;
+    EXPECT_EQ(calls, 1);
+}
+
+TEST(CompactRegistry, Budget)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    for (int i = 0; i < 10; ++i) {
+        Setting<int> s("/compact/budget/" + std::to_string(i), sm);
+    }
+    Setting<int> kept("/compact/budget/kept", sm);
+
+    std::size_t removed = 0;
+    for (int i = 0; i < 4; ++i) {
+        removed += sm->compactRegistry(3);
+    }
+
+    EXPECT_EQ(removed, 10);
+    EXPECT_EQ(sm->memoryUsage().settingCount, 1);
+    EXPECT_TRUE(kept.isValid());
+    EXPECT_EQ(sm->compactRegistry(3), 0);
+}
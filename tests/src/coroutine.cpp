@@ -0,0 +1,242 @@
+#include <gtest/gtest.h>
+
+#include <coroutine>
+#include <optional>
+#include <pajlada/settings.hpp>
+#include <utility>
+#include <vector>
+
+using namespace pajlada::Settings;
+using SaveMethod = SettingManager::SaveMethod;
+
+namespace {
+
+/// Minimal fire-and-forget coroutine that starts running immediately
+struct Task {
+    struct promise_type {
+        Task
+        get_return_object()
+        {
+            return {};
+        }
+
+        std::suspend_never
+        initial_suspend() noexcept
+        {
+            return {};
+        }
+
+        std::suspend_never
+        final_suspend() noexcept
+        {
+            return {};
+        }
+
+        void
+        return_void()
+        {
+        }
+
+        void
+        unhandled_exception()
+        {
+            std::terminate();
+        }
+    };
+};
+
+/// Coroutine that starts running immediately & is destroyed with its owner
+struct OwnedTask {
+    struct promise_type {
+        OwnedTask
+        get_return_object()
+        {
+            return OwnedTask{
+                std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+
+        std::suspend_never
+        initial_suspend() noexcept
+        {
+            return {};
+        }
+
+        std::suspend_always
+        final_suspend() noexcept
+        {
+            return {};
+        }
+
+        void
+        return_void()
+        {
+        }
+
+        void
+        unhandled_exception()
+        {
+            std::terminate();
+        }
+    };
+
+    explicit OwnedTask(std::coroutine_handle<promise_type> _handle)
+        : handle(_handle)
+    {
+    }
+
+    OwnedTask(OwnedTask &&other) noexcept
+        : handle(std::exchange(other.handle, nullptr))
+    {
+    }
+
+    OwnedTask &operator=(OwnedTask &&other) = delete;
+    OwnedTask(const OwnedTask &) = delete;
+    OwnedTask &operator=(const OwnedTask &) = delete;
+
+    ~OwnedTask()
+    {
+        if (this->handle) {
+            this->handle.destroy();
+        }
+    }
+
+    std::coroutine_handle<promise_type> handle;
+};
+
+OwnedTask
+collectChangesOwned(Setting<int> &setting, std::vector<int> &values)
+{
+    auto change = co_await setting.nextChange();
+    values.push_back(change.value);
+}
+
+Task
+destroyOnChange(Setting<int> &setting, std::optional<OwnedTask> &task)
+{
+    co_await setting.nextChange();
+    task.reset();
+}
+
+Task
+collectChanges(Setting<int> &setting, int count, std::vector<int> &values,
+               std::vector<SignalArgs::Source> &sources)
+{
+    for (int i = 0; i < count; ++i) {
+        auto change = co_await setting.nextChange();
+        values.push_back(change.value);
+        sources.push_back(change.args.source);
+    }
+}
+
+}  // namespace
+
+TEST(Coroutine, nextChange)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    Setting<int> a("/coroutine/next-change/a", sm);
+
+    std::vector<int> values;
+    std::vector<SignalArgs::Source> sources;
+    collectChanges(a, 2, values, sources);
+
+    EXPECT_TRUE(values.empty());
+
+    a = 5;
+    ASSERT_EQ(values.size(), 1);
+    EXPECT_EQ(values[0], 5);
+    EXPECT_EQ(sources[0], SignalArgs::Source::Setter);
+
+    a = 6;
+    ASSERT_EQ(values.size(), 2);
+    EXPECT_EQ(values[1], 6);
+
+    // The coroutine has finished, further changes don't reach it
+    a = 7;
+    EXPECT_EQ(values.size(), 2);
+}
+
+TEST(Coroutine, multipleWaiters)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    Setting<int> a("/coroutine/multiple-waiters/a", sm);
+    Setting<int> a2("/coroutine/multiple-waiters/a", sm);
+
+    std::vector<int> values1;
+    std::vector<int> values2;
+    std::vector<SignalArgs::Source> sources;
+    collectChanges(a, 1, values1, sources);
+    collectChanges(a2, 1, values2, sources);
+
+    // Both waiters are resumed by a change through another handle
+    Setting<int> a3("/coroutine/multiple-waiters/a", sm);
+    a3 = 3;
+
+    ASSERT_EQ(values1.size(), 1);
+    ASSERT_EQ(values2.size(), 1);
+    EXPECT_EQ(values1[0], 3);
+    EXPECT_EQ(values2[0], 3);
+}
+
+TEST(Coroutine, load)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    Setting<int> a("/a", sm);
+
+    std::vector<int> values;
+    std::vector<SignalArgs::Source> sources;
+    collectChanges(a, 1, values, sources);
+
+    ASSERT_EQ(sm->loadFrom("files/in.normal.json"),
+              SettingManager::LoadError::NoError);
+
+    ASSERT_EQ(values.size(), 1);
+    EXPECT_EQ(values[0], 3);
+}
+
+TEST(Coroutine, invalidSetting)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    Setting<int> a("/coroutine/invalid-setting/a", sm);
+    a = 1;
+    ASSERT_TRUE(sm->removeSetting("/coroutine/invalid-setting/a"));
+    ASSERT_FALSE(a.isValid());
+
+    std::vector<int> values;
+    std::vector<SignalArgs::Source> sources;
+    collectChanges(a, 1, values, sources);
+
+    // An invalid setting never changes, so the coroutine is not suspended
+    ASSERT_EQ(values.size(), 1);
+    EXPECT_EQ(values[0], 0);
+}
+
+TEST(Coroutine, destroyedWhileResumingOthers)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    Setting<int> a("/coroutine/destroyed-while-resuming/a", sm);
+
+    std::vector<int> values;
+    std::optional<OwnedTask> owned;
+
+    // Resumed first, destroys the other waiter before it's resumed
+    destroyOnChange(a, owned);
+    owned.emplace(collectChangesOwned(a, values));
+
+    a = 1;
+
+    EXPECT_FALSE(owned.has_value());
+    EXPECT_TRUE(values.empty());
+
+    a = 2;
+    EXPECT_TRUE(values.empty());
+}
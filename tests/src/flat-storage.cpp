@@ -0,0 +1,270 @@
+#include <gtest/gtest.h>
+#include <rapidjson/pointer.h>
+
+#include <pajlada/settings.hpp>
+#include <string>
+
+using namespace pajlada::Settings;
+using SaveResult = SettingManager::SaveResult;
+using SaveMethod = SettingManager::SaveMethod;
+using LoadError = SettingManager::LoadError;
+
+TEST(FlatStorage, WritesDocumentLazily)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    Setting<int> a("/flat/lazy/a", SettingOption::FlatStorage, sm);
+
+    a = 5;
+    EXPECT_EQ(a.getValue(), 5);
+
+    // Reads through the manager don't write to the document
+    EXPECT_EQ(sm->get("/flat/lazy/a"), nullptr);
+    EXPECT_EQ(rapidjson::Pointer("/flat/lazy/a").Get(sm->document), nullptr);
+
+    EXPECT_EQ(sm->flushFlatStorage(), 1);
+    const auto *value = sm->get("/flat/lazy/a");
+    ASSERT_NE(value, nullptr);
+    EXPECT_EQ(value->GetInt(), 5);
+
+    a = 6;
+    EXPECT_EQ(sm->flushFlatStorage(), 1);
+    EXPECT_EQ(sm->flushFlatStorage(), 0);
+    EXPECT_EQ(rapidjson::Pointer("/flat/lazy/a").Get(sm->document)->GetInt(),
+              6);
+}
+
+TEST(FlatStorage, DefaultValue)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    Setting<double> a("/flat/default/a", 1.5, SettingOption::FlatStorage, sm);
+
+    EXPECT_EQ(a.getValue(), 1.5);
+    EXPECT_FALSE(a.hasValueBeenSet());
+
+    a = 2.5;
+    EXPECT_EQ(a.getValue(), 2.5);
+    EXPECT_TRUE(a.hasValueBeenSet());
+
+    a.resetToDefaultValue();
+    EXPECT_EQ(a.getValue(), 1.5);
+    EXPECT_FALSE(a.hasValueBeenSet());
+    EXPECT_EQ(sm->get("/flat/default/a"), nullptr);
+}
+
+TEST(FlatStorage, SharedWithRegularSetting)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    Setting<bool> flat("/flat/shared/a", SettingOption::FlatStorage, sm);
+    Setting<bool> regular("/flat/shared/a", sm);
+
+    flat = true;
+    EXPECT_TRUE(regular.getValue());
+
+    regular = false;
+    EXPECT_FALSE(flat.getValue());
+
+    sm->set("/flat/shared/a", rapidjson::Value(true));
+    EXPECT_TRUE(flat.getValue());
+}
+
+TEST(FlatStorage, DifferentKindFallsBack)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    Setting<int> integer("/flat/kind/a", SettingOption::FlatStorage, sm);
+    Setting<double> floating("/flat/kind/a", SettingOption::FlatStorage, sm);
+
+    integer = 5;
+    EXPECT_EQ(floating.getValue(), 5.0);
+
+    floating = 7.0;
+    EXPECT_EQ(integer.getValue(), 7);
+}
+
+TEST(FlatStorage, Listeners)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    Setting<std::uint64_t> a("/flat/listeners/a",
+                             SettingOption::FlatStorage |
+                                 SettingOption::CompareBeforeSet,
+                             sm);
+
+    int count = 0;
+    std::uint64_t currentValue = 0;
+    a.connect(
+        [&](const std::uint64_t &newValue) {
+            ++count;
+            currentValue = newValue;
+        },
+        false);
+
+    a = 5;
+    EXPECT_EQ(count, 1);
+    EXPECT_EQ(currentValue, 5);
+
+    // CompareBeforeSet compares with the slot
+    a = 5;
+    EXPECT_EQ(count, 1);
+
+    a = 6;
+    EXPECT_EQ(count, 2);
+    EXPECT_EQ(currentValue, 6);
+}
+
+TEST(FlatStorage, SaveAndLoad)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    Setting<int> a("/flat/save/a", SettingOption::FlatStorage, sm);
+    Setting<bool> b("/flat/save/b", SettingOption::FlatStorage, sm);
+
+    a = 5;
+    b = true;
+
+    EXPECT_EQ(SaveResult::Success, sm->saveAs("files/out.flat-storage.json"));
+
+    a = 6;
+    EXPECT_EQ(a.getValue(), 6);
+
+    // Loading replaces values that have not been saved
+    ASSERT_EQ(sm->loadFrom("files/out.flat-storage.json"),
+              LoadError::NoError);
+    EXPECT_EQ(a.getValue(), 5);
+    EXPECT_TRUE(b.getValue());
+
+    auto other = std::make_shared<SettingManager>();
+    other->saveMethod = SaveMethod::SaveManually;
+    ASSERT_EQ(other->loadFrom("files/out.flat-storage.json"),
+              LoadError::NoError);
+
+    Setting<int> otherA("/flat/save/a", SettingOption::FlatStorage, other);
+    EXPECT_EQ(otherA.getValue(), 5);
+}
+
+TEST(FlatStorage, Remove)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    Setting<int> a("/flat/remove/a", 3, SettingOption::FlatStorage, sm);
+
+    a = 5;
+    EXPECT_TRUE(sm->removeSettingSoft("/flat/remove/a"));
+
+    EXPECT_EQ(a.getValue(), 3);
+    EXPECT_EQ(sm->get("/flat/remove/a"), nullptr);
+}
+
+TEST(FlatStorage, WritesKeepOtherValues)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    Setting<int> a("/flat/writes/a", SettingOption::FlatStorage, sm);
+    Setting<int> b("/flat/writes/b", SettingOption::FlatStorage, sm);
+    Setting<int> nested("/flat/writes/c/d", SettingOption::FlatStorage, sm);
+
+    a = 1;
+    b = 2;
+    nested = 3;
+
+    // Writing next to a value keeps it, writing above it replaces it
+    sm->set("/flat/writes/e", rapidjson::Value(4));
+    sm->set("/flat/writes/c", rapidjson::Value(5));
+
+    EXPECT_EQ(a.getValue(), 1);
+    EXPECT_EQ(b.getValue(), 2);
+    EXPECT_EQ(nested.getValue(), 0);
+
+    EXPECT_EQ(sm->flushFlatStorage(), 2);
+    EXPECT_EQ(sm->get("/flat/writes/a")->GetInt(), 1);
+    EXPECT_EQ(sm->get("/flat/writes/b")->GetInt(), 2);
+    EXPECT_EQ(sm->get("/flat/writes/c")->GetInt(), 5);
+}
+
+TEST(FlatStorage, SaveOnSettingChangeKeepsWrite)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+    sm->setPath("files/out.flat-storage-save-on-change.json");
+
+    Setting<int> child("/flat/save-on-change/parent/child",
+                       SettingOption::FlatStorage, sm);
+
+    // Dirty, not written to the document yet
+    child = 2;
+
+    // The save flushes the dirty child, which must not undo this write
+    sm->saveMethod = SaveMethod::SaveOnSettingChange;
+    rapidjson::Value parent(rapidjson::kObjectType);
+    parent.AddMember("child", rapidjson::Value(3).Move(),
+                     sm->document.GetAllocator());
+    ASSERT_TRUE(sm->set("/flat/save-on-change/parent", parent));
+
+    EXPECT_EQ(child.getValue(), 3);
+    EXPECT_EQ(sm->get("/flat/save-on-change/parent/child")->GetInt(), 3);
+}
+
+TEST(FlatStorage, WritesOnlyReloadTheirPath)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    Setting<int> ab("/flat/prefix/ab", SettingOption::FlatStorage, sm);
+    Setting<int> a1("/flat/prefix/a/1", SettingOption::FlatStorage, sm);
+    Setting<int> a("/flat/prefix/a", SettingOption::FlatStorage, sm);
+
+    ab = 1;
+    a1 = 2;
+
+    // `ab` only shares characters with `a`, not a path token
+    sm->set("/flat/prefix/a", rapidjson::Value(3));
+    EXPECT_EQ(ab.getValue(), 1);
+    EXPECT_EQ(a1.getValue(), 0);
+    EXPECT_EQ(a.getValue(), 3);
+
+    sm->set("/flat/prefix", rapidjson::Value(rapidjson::kObjectType));
+    EXPECT_EQ(ab.getValue(), 0);
+    EXPECT_EQ(a.getValue(), 0);
+}
+
+TEST(FlatStorage, ConnectJSONSeesSlot)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    Setting<int> a("/flat/json/a", SettingOption::FlatStorage, sm);
+    a = 5;
+
+    int value = 0;
+    a.connectJSON([&](const rapidjson::Value &json, const SignalArgs &) {
+        value = json.GetInt();
+    });
+    EXPECT_EQ(value, 5);
+}
+
+TEST(FlatStorage, IgnoredForStrings)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    Setting<std::string> a("/flat/string/a", SettingOption::FlatStorage, sm);
+
+    a = "hello";
+    EXPECT_EQ(a.getValue(), "hello");
+
+    const auto *value =
+        rapidjson::Pointer("/flat/string/a").Get(sm->document);
+    ASSERT_NE(value, nullptr);
+    EXPECT_STREQ(value->GetString(), "hello");
+}
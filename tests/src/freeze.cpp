@@ -0,0 +1,171 @@
+#include <gtest/gtest.h>
+
+#include <pajlada/settings.hpp>
+#include <pajlada/settings/atomicsetting.hpp>
+#include <pajlada/settings/detail/frozenregistry.hpp>
+#include <string>
+#include <vector>
+
+#include "common.hpp"
+
+using namespace pajlada::Settings;
+using SaveResult = SettingManager::SaveResult;
+using SaveMethod = SettingManager::SaveMethod;
+using LoadError = SettingManager::LoadError;
+
+namespace {
+
+constexpr Key<"/freeze/key/a", int> keyA;
+
+}  // namespace
+
+TEST(Freeze, RejectsWrites)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    Setting<int> a("/freeze/writes/a", sm);
+    AtomicSetting<bool> b("/freeze/writes/b", sm);
+    Setting<std::vector<int>> c("/freeze/writes/c", sm);
+    a = 5;
+    b = true;
+    c = {1, 2};
+
+    EXPECT_FALSE(sm->isFrozen());
+    sm->freeze();
+    EXPECT_TRUE(sm->isFrozen());
+
+    EXPECT_FALSE(a.setValue(6));
+    EXPECT_EQ(a.getValue(), 5);
+
+    EXPECT_FALSE(b.setValue(false));
+    EXPECT_TRUE(b.getValue());
+
+    c.push_back(3);
+    EXPECT_EQ(c.getValue(), (std::vector<int>{1, 2}));
+
+    EXPECT_FALSE(sm->set("/freeze/writes/a", rapidjson::Value(7)));
+    EXPECT_EQ(a.getValue(), 5);
+
+    a.resetToDefaultValue();
+    EXPECT_EQ(a.getValue(), 5);
+
+    EXPECT_FALSE(sm->removeSetting("/freeze/writes/a"));
+    EXPECT_FALSE(sm->removeSettingSoft("/freeze/writes/a"));
+    EXPECT_TRUE(a.isValid());
+    EXPECT_EQ(sm->compactRegistry(), 0);
+
+    EXPECT_EQ(sm->loadFrom("files/in.normal.json"), LoadError::Frozen);
+    EXPECT_EQ(WaitForLoad(*sm, sm->loadAsync("files/in.normal.json")),
+              LoadError::Frozen);
+    EXPECT_EQ(a.getValue(), 5);
+}
+
+TEST(Freeze, FrozenLookup)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    std::vector<std::unique_ptr<Setting<int>>> settings;
+    for (int i = 0; i < 100; ++i) {
+        settings.push_back(std::make_unique<Setting<int>>(
+            "/freeze/lookup/" + std::to_string(i), sm));
+        *settings.back() = i;
+    }
+
+    Setting<int> fromKey(keyA, sm);
+    fromKey = 42;
+
+    // In the document, but not registered
+    sm->set("/freeze/lookup/unregistered", rapidjson::Value(7));
+
+    sm->freeze();
+
+    for (int i = 0; i < 100; ++i) {
+        Setting<int> again("/freeze/lookup/" + std::to_string(i), sm);
+        EXPECT_EQ(again.getData().lock(), settings[i]->getData().lock());
+        EXPECT_EQ(again.getValue(), i);
+        // Served without locking from here on
+        EXPECT_EQ(again.getValue(), i);
+    }
+
+    Setting<int> keyAgain(keyA, sm);
+    EXPECT_EQ(keyAgain.getData().lock(), fromKey.getData().lock());
+    EXPECT_EQ(keyAgain.getValue(), 42);
+
+    // The registry doesn't grow anymore
+    const auto registered = sm->memoryUsage().settingCount;
+    Setting<int> unregistered("/freeze/lookup/unregistered", 3, sm);
+    EXPECT_FALSE(unregistered.isValid());
+    EXPECT_EQ(unregistered.getValue(), 3);
+    EXPECT_EQ(sm->get("/freeze/lookup/unregistered")->GetInt(), 7);
+    EXPECT_TRUE(
+        SettingManager::getSetting("/freeze/lookup/unknown", sm).expired());
+    AtomicSetting<int> atomic("/freeze/lookup/unregistered", 4, sm);
+    EXPECT_FALSE(atomic.isValid());
+    EXPECT_EQ(atomic.getValue(), 4);
+    EXPECT_EQ(sm->memoryUsage().settingCount, registered);
+}
+
+TEST(Freeze, Save)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    Setting<int> a("/freeze/save/a", SettingOption::FlatStorage, sm);
+    a = 5;
+
+    sm->freeze();
+
+    EXPECT_EQ(SaveResult::Success, sm->saveAs("files/out.freeze.json"));
+
+    auto other = std::make_shared<SettingManager>();
+    other->saveMethod = SaveMethod::SaveManually;
+    ASSERT_EQ(other->loadFrom("files/out.freeze.json"), LoadError::NoError);
+    EXPECT_EQ(Setting<int>::get("/freeze/save/a", other), 5);
+}
+
+TEST(Freeze, FrozenRegistry)
+{
+    std::vector<PathID> paths;
+    detail::FrozenRegistry::Registry registry;
+    for (int i = 0; i < 1000; ++i) {
+        auto path = PathID::intern("/freeze/registry/" + std::to_string(i));
+        paths.push_back(path);
+        registry[path.view()] = nullptr;
+    }
+
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+    for (auto &[path, setting] : registry) {
+        setting = SettingManager::getSetting(std::string(path), sm).lock();
+    }
+
+    detail::FrozenRegistry frozen;
+    frozen.build(registry);
+
+    for (const auto &path : paths) {
+        const auto *setting = frozen.find(path.view());
+        ASSERT_NE(setting, nullptr);
+        EXPECT_EQ((*setting)->getPathID(), path);
+    }
+
+    EXPECT_EQ(frozen.find("/freeze/registry/1000"), nullptr);
+    EXPECT_EQ(frozen.find(""), nullptr);
+
+    // Buckets that don't fit with the first seed go to the overflow table
+    detail::FrozenRegistry overflowing;
+    overflowing.build(registry, 1);
+    EXPECT_GT(overflowing.overflowSize(), 0);
+
+    for (const auto &path : paths) {
+        const auto *setting = overflowing.find(path.view());
+        ASSERT_NE(setting, nullptr);
+        EXPECT_EQ((*setting)->getPathID(), path);
+    }
+    EXPECT_EQ(overflowing.find("/freeze/registry/1000"), nullptr);
+
+    detail::FrozenRegistry empty;
+    empty.build({});
+    EXPECT_EQ(empty.find("/freeze/registry/0"), nullptr);
+}
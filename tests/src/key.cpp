@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+
+#include <pajlada/settings.hpp>
+#include <pajlada/settings/key.hpp>
+#include <string>
+#include <string_view>
+
+using namespace pajlada::Settings;
+using SaveMethod = SettingManager::SaveMethod;
+
+namespace {
+
+constexpr Key<"/key/font/size", int> fontSize;
+constexpr Key<"/key/font/family", std::string> fontFamily;
+
+using Escaped = detail::KeyPath<"/a~1b/~0c/12/012">;
+
+static_assert(Key<"/key/font/size", int>::hash ==
+              detail::fnv1a("/key/font/size"));
+static_assert(Key<"/key/font/size", int>::hash !=
+              Key<"/key/font/family", std::string>::hash);
+
+static_assert(Escaped::TOKEN_COUNT == 4);
+static_assert(std::string_view(Escaped::tokens[0].name) == "a/b");
+static_assert(std::string_view(Escaped::tokens[1].name) == "~c");
+static_assert(Escaped::tokens[1].index == rapidjson::kPointerInvalidIndex);
+static_assert(Escaped::tokens[2].index == 12);
+// Leading zeroes make a token a member name, just like rapidjson's parser
+static_assert(Escaped::tokens[3].index == rapidjson::kPointerInvalidIndex);
+
+static_assert(detail::KeyPath<"">::TOKEN_COUNT == 0);
+
+}  // namespace
+
+TEST(Key, SharesDataWithPath)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    Setting<int> fromKey(fontSize, sm);
+    Setting<int> fromPath("/key/font/size", sm);
+
+    EXPECT_EQ(fromKey.getPath(), "/key/font/size");
+    EXPECT_EQ(fromKey.getPathID(), fromPath.getPathID());
+    EXPECT_EQ(fromKey.getData().lock(), fromPath.getData().lock());
+
+    fromKey = 14;
+    EXPECT_EQ(fromPath.getValue(), 14);
+
+    fromPath = 16;
+    EXPECT_EQ(fromKey.getValue(), 16);
+
+    const auto *value = sm->get("/key/font/size");
+    ASSERT_NE(value, nullptr);
+    EXPECT_EQ(value->GetInt(), 16);
+}
+
+TEST(Key, DefaultValue)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    Setting<std::string> family(fontFamily, "Arial", sm);
+    EXPECT_EQ(family.getValue(), "Arial");
+
+    family = "Comic Sans";
+    EXPECT_EQ(Setting<std::string>(fontFamily, sm).getValue(), "Comic Sans");
+}
+
+TEST(Key, RebindsAfterCompaction)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    {
+        Setting<int> s(fontSize, sm);
+        s = 20;
+    }
+
+    EXPECT_EQ(sm->compactRegistry(), 1);
+
+    Setting<int> s(fontSize, sm);
+    EXPECT_TRUE(s.isValid());
+    EXPECT_EQ(s.getValue(), 20);
+}
+
+TEST(Key, SeparateManagers)
+{
+    auto sm1 = std::make_shared<SettingManager>();
+    sm1->saveMethod = SaveMethod::SaveManually;
+    auto sm2 = std::make_shared<SettingManager>();
+    sm2->saveMethod = SaveMethod::SaveManually;
+
+    Setting<int> a(fontSize, sm1);
+    Setting<int> b(fontSize, sm2);
+
+    a = 1;
+    b = 2;
+
+    EXPECT_NE(a.getData().lock(), b.getData().lock());
+    EXPECT_EQ(Setting<int>(fontSize, sm1).getValue(), 1);
+    EXPECT_EQ(Setting<int>(fontSize, sm2).getValue(), 2);
+}
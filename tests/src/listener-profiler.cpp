@@ -0,0 +1,128 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <pajlada/settings.hpp>
+#include <thread>
+
+using namespace pajlada::Settings;
+using SaveMethod = SettingManager::SaveMethod;
+
+using namespace std::chrono_literals;
+
+TEST(ListenerProfiler, DisabledByDefault)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    Setting<int> a("/listener-profiler/disabled/a", sm);
+    a.connect([](int) {}, false);
+
+    a = 1;
+
+    EXPECT_FALSE(sm->listenerProfiler().isEnabled());
+    EXPECT_TRUE(sm->listenerProfiler().topSlowest(10).empty());
+}
+
+TEST(ListenerProfiler, TopSlowest)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+    sm->listenerProfiler().setEnabled();
+
+    Setting<int> a("/listener-profiler/top/a", sm);
+    Setting<int> b("/listener-profiler/top/b", sm);
+
+    a.connect([](int) {}, false, "fast");
+    b.connect(
+        [](int) {
+            std::this_thread::sleep_for(20ms);
+        },
+        false, "slow");
+    // Unlabelled
+    b.connect([](int) {}, false);
+
+    a = 1;
+    a = 2;
+    b = 1;
+
+    auto top = sm->listenerProfiler().topSlowest(2);
+    ASSERT_EQ(top.size(), 2);
+
+    EXPECT_EQ(top[0].path, "/listener-profiler/top/b");
+    EXPECT_EQ(top[0].label, "slow");
+    EXPECT_EQ(top[0].calls, 1);
+    EXPECT_GE(top[0].max, 20ms);
+
+    auto all = sm->listenerProfiler().topSlowest(10);
+    ASSERT_EQ(all.size(), 3);
+    for (const auto &profile : all) {
+        if (profile.label == "fast") {
+            EXPECT_EQ(profile.path, "/listener-profiler/top/a");
+            EXPECT_EQ(profile.calls, 2);
+        }
+    }
+
+    sm->listenerProfiler().reset();
+    EXPECT_TRUE(sm->listenerProfiler().topSlowest(10).empty());
+}
+
+TEST(ListenerProfiler, ConnectedWhileDisabled)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    Setting<int> a("/listener-profiler/connected-disabled/a", sm);
+
+    int calls = 0;
+    a.connect(
+        [&](int) {
+            ++calls;
+        },
+        false, "before");
+
+    sm->listenerProfiler().setEnabled();
+
+    a.connect([](int) {}, false, "after");
+
+    a = 1;
+
+    // Both are invoked, only the one connected while enabled is timed
+    EXPECT_EQ(calls, 1);
+    auto all = sm->listenerProfiler().topSlowest(10);
+    ASSERT_EQ(all.size(), 1);
+    EXPECT_EQ(all[0].label, "after");
+    EXPECT_EQ(all[0].calls, 1);
+}
+
+TEST(ListenerProfiler, SlowThreshold)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    auto &profiler = sm->listenerProfiler();
+    profiler.setEnabled();
+
+    std::vector<std::string> slowLabels;
+    profiler.setSlowThreshold(
+        10ms, [&](const ListenerProfile &profile, auto duration) {
+            EXPECT_GE(duration, 10ms);
+            slowLabels.push_back(profile.label);
+        });
+
+    Setting<int> a("/listener-profiler/threshold/a", sm);
+    a.connect([](int) {}, false, "fast");
+    a.connect(
+        [](int) {
+            std::this_thread::sleep_for(15ms);
+        },
+        false, "slow");
+
+    a = 1;
+
+    ASSERT_EQ(slowLabels.size(), 1);
+    EXPECT_EQ(slowLabels[0], "slow");
+
+    profiler.setSlowThreshold(10ms, {});
+    a = 2;
+    EXPECT_EQ(slowLabels.size(), 1);
+}
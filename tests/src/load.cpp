@@ -1,6 +1,12 @@
 #include <gtest/gtest.h>
 
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
 #include <pajlada/settings.hpp>
+#include <thread>
+#include <vector>
 
 #include "common.hpp"
 
@@ -244,3 +250,194 @@ TEST(Load, LoadFromWithTemporaryButSaveFails)
                             fs::perms::group_read | fs::perms::others_read);
 }
 #endif
+
+TEST(Load, LoadAsync)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SettingManager::SaveMethod::SaveManually;
+    sm->setPath("thisfiledoesnotexist.json");
+    sm->setBackupEnabled(false);
+
+    Setting<int> a("/a", 1, sm);
+
+    EXPECT_EQ(a, 1);
+
+    EXPECT_EQ(WaitForLoad(*sm, sm->loadAsync("files/in.normal.json")),
+              LoadError::NoError);
+
+    EXPECT_EQ(a, 3);
+
+    a = 2;
+
+    EXPECT_EQ(a, 2);
+
+    // loadAsync, like load, updates the default path
+    EXPECT_EQ(WaitForLoad(*sm, sm->loadAsync()), LoadError::NoError);
+
+    EXPECT_EQ(a, 3);
+
+    EXPECT_EQ(
+        WaitForLoad(*sm, sm->loadAsync("files/thisfiledoesnotexist.json")),
+        LoadError::CannotOpenFile);
+    EXPECT_EQ(WaitForLoad(*sm, sm->loadAsync("files/bad-1.json")),
+              LoadError::JSONParseError);
+
+    EXPECT_EQ(a, 3);
+}
+
+TEST(Load, NonObjectRootKeepsDocument)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SettingManager::SaveMethod::SaveManually;
+    sm->setBackupEnabled(false);
+
+    Setting<int> a("/a", 1, sm);
+
+    ASSERT_EQ(sm->loadFrom("files/in.normal.json"), LoadError::NoError);
+    EXPECT_EQ(a, 3);
+
+    // The root of this file is a number
+    EXPECT_EQ(sm->loadFrom("files/bad-3.json"), LoadError::JSONParseError);
+    EXPECT_TRUE(sm->document.IsObject());
+    EXPECT_EQ(a, 3);
+}
+
+TEST(Load, LoadAsyncPending)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SettingManager::SaveMethod::SaveManually;
+    sm->setBackupEnabled(false);
+
+    Setting<int> a("/a", 1, sm);
+
+    auto future = sm->loadAsync("files/in.normal.json");
+
+    // Without an executor, the document is swapped in by applyPendingLoads
+    std::size_t applied = 0;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (applied == 0 && std::chrono::steady_clock::now() < deadline) {
+        EXPECT_EQ(future.wait_for(std::chrono::seconds(0)),
+                  std::future_status::timeout);
+        EXPECT_EQ(a, 1);
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        applied = sm->applyPendingLoads();
+    }
+    ASSERT_EQ(applied, 1);
+
+    ASSERT_EQ(future.wait_for(std::chrono::seconds(0)),
+              std::future_status::ready);
+    EXPECT_EQ(future.get(), LoadError::NoError);
+    EXPECT_EQ(a, 3);
+    EXPECT_EQ(sm->applyPendingLoads(), 0);
+}
+
+TEST(Load, LoadAsyncPendingCancelled)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SettingManager::SaveMethod::SaveManually;
+    sm->setBackupEnabled(false);
+
+    auto future = sm->loadAsync("files/in.normal.json");
+
+    sm.reset();
+
+    // Completed by the destructor, or by the worker once it's done parsing
+    ASSERT_EQ(future.wait_for(std::chrono::seconds(5)),
+              std::future_status::ready);
+    EXPECT_EQ(future.get(), LoadError::Cancelled);
+}
+
+namespace {
+
+/// Collects tasks so they can be run on the test's thread
+class QueueExecutor
+{
+public:
+    SettingManager::Executor
+    executor()
+    {
+        return [this](std::function<void()> task) {
+            std::unique_lock lock(this->mutex);
+            this->tasks.push_back(std::move(task));
+            this->cv.notify_all();
+        };
+    }
+
+    /// Wait for the next task & run it
+    bool
+    runOne()
+    {
+        std::function<void()> task;
+
+        {
+            std::unique_lock lock(this->mutex);
+            if (!this->cv.wait_for(lock, std::chrono::seconds(5), [this] {
+                    return !this->tasks.empty();
+                })) {
+                return false;
+            }
+            task = std::move(this->tasks.front());
+            this->tasks.erase(this->tasks.begin());
+        }
+
+        task();
+        return true;
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<std::function<void()>> tasks;
+};
+
+}  // namespace
+
+TEST(Load, LoadAsyncExecutor)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SettingManager::SaveMethod::SaveManually;
+    sm->setBackupEnabled(false);
+
+    Setting<int> a("/a", 1, sm);
+
+    int invocations = 0;
+    a.connect(
+        [&](const int &) {
+            ++invocations;
+        },
+        false);
+
+    QueueExecutor queue;
+
+    auto future = sm->loadAsync("files/in.normal.json", queue.executor());
+
+    // The document is only swapped in by the executor
+    EXPECT_EQ(a, 1);
+    EXPECT_EQ(invocations, 0);
+
+    ASSERT_TRUE(queue.runOne());
+
+    ASSERT_EQ(future.wait_for(std::chrono::seconds(0)),
+              std::future_status::ready);
+    EXPECT_EQ(future.get(), LoadError::NoError);
+    EXPECT_EQ(a, 3);
+    EXPECT_EQ(invocations, 1);
+}
+
+TEST(Load, LoadAsyncCancelled)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SettingManager::SaveMethod::SaveManually;
+    sm->setBackupEnabled(false);
+
+    QueueExecutor queue;
+
+    auto future = sm->loadAsync("files/in.normal.json", queue.executor());
+
+    sm.reset();
+
+    ASSERT_TRUE(queue.runOne());
+
+    EXPECT_EQ(future.get(), LoadError::Cancelled);
+}
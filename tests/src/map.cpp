@@ -72,3 +72,153 @@ TEST(Map, Complex)
 
     EXPECT_EQ(SaveResult::Success, sm->saveAs("files/out.complexmap.json"));
 }
+
+TEST(Map, ForEachObjectMember)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SettingManager::SaveMethod::SaveManually;
+
+    EXPECT_EQ(LoadError::NoError, sm->loadFrom("files/in.simplemap.json"));
+
+    std::vector<std::string_view> keys;
+    EXPECT_TRUE(sm->forEachObjectKey("/map", [&](std::string_view key) {
+        keys.push_back(key);
+    }));
+    ASSERT_EQ(keys, (std::vector<std::string_view>{"a", "b", "c"}));
+
+    // Keys are read straight from the document
+    EXPECT_EQ(keys[0].data(),
+              sm->document["map"].MemberBegin()->name.GetString());
+
+    int sum = 0;
+    EXPECT_TRUE(sm->forEachObjectMember(
+        "/map", [&](std::string_view key, const rapidjson::Value &value) {
+            if (key == "a") {
+                sum += value.GetInt();
+            }
+            if (key == "b") {
+                EXPECT_STREQ(value.GetString(), "asd");
+            }
+        }));
+    EXPECT_EQ(sum, 1);
+
+    EXPECT_FALSE(sm->forEachObjectKey("/map/a", [](std::string_view) {}));
+    EXPECT_FALSE(sm->forEachObjectKey("/missing", [](std::string_view) {}));
+}
+
+TEST(Map, InsertOrAssignAndErase)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SettingManager::SaveMethod::SaveManually;
+
+    Setting<std::map<std::string, int>> map("/members/map", sm);
+    map = {{"a", 1}, {"b", 2}};
+
+    std::vector<std::pair<SignalArgs::Change, std::string>> changes;
+    map.connectJSON(
+        [&](const rapidjson::Value &value, const SignalArgs &args) {
+            EXPECT_TRUE(value.IsObject());
+            changes.emplace_back(args.change, args.key);
+        },
+        false);
+
+    EXPECT_TRUE(map.insertOrAssign("c", 3));
+    EXPECT_TRUE(map.insertOrAssign("a", 10));
+    EXPECT_EQ(map.getValue(),
+              (std::map<std::string, int>{{"a", 10}, {"b", 2}, {"c", 3}}));
+    EXPECT_EQ(sm->get("/members/map/c")->GetInt(), 3);
+    EXPECT_EQ(sm->get("/members/map/a")->GetInt(), 10);
+
+    EXPECT_TRUE(map.erase("b"));
+    EXPECT_FALSE(map.erase("b"));
+    EXPECT_EQ(map.getValue(),
+              (std::map<std::string, int>{{"a", 10}, {"c", 3}}));
+    EXPECT_EQ(sm->get("/members/map/b"), nullptr);
+    EXPECT_EQ(sm->get("/members/map")->MemberCount(), 2);
+
+    using Change = SignalArgs::Change;
+    std::vector<std::pair<Change, std::string>> expected{
+        {Change::MemberAssigned, "c"},
+        {Change::MemberAssigned, "a"},
+        {Change::MemberErased, "b"},
+    };
+    EXPECT_EQ(changes, expected);
+
+    // Setting the whole value is still a Value change
+    map = std::map<std::string, int>{};
+    ASSERT_EQ(changes.size(), 4);
+    EXPECT_EQ(changes[3].first, Change::Value);
+    EXPECT_TRUE(changes[3].second.empty());
+}
+
+TEST(Map, InsertOrAssignDefaultValue)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SettingManager::SaveMethod::SaveManually;
+
+    Setting<std::map<std::string, int>> map(
+        "/members/default", std::map<std::string, int>{{"a", 1}}, sm);
+
+    // Nothing in the document yet, the default value is written with the new member
+    EXPECT_TRUE(map.insertOrAssign("b", 2));
+    EXPECT_EQ(map.getValue(),
+              (std::map<std::string, int>{{"a", 1}, {"b", 2}}));
+    EXPECT_EQ(sm->get("/members/default/a")->GetInt(), 1);
+
+    EXPECT_FALSE(map.erase("c"));
+}
+
+TEST(Map, InsertOrAssignCompareBeforeSet)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SettingManager::SaveMethod::SaveManually;
+
+    Setting<std::map<std::string, int>> map(
+        "/members/compare", SettingOption::CompareBeforeSet, sm);
+    map = std::map<std::string, int>{{"a", 1}};
+
+    int count = 0;
+    map.connect(
+        [&](const std::map<std::string, int> &) {
+            ++count;
+        },
+        false);
+
+    EXPECT_FALSE(map.insertOrAssign("a", 1));
+    EXPECT_EQ(count, 0);
+
+    EXPECT_TRUE(map.insertOrAssign("a", 2));
+    EXPECT_EQ(count, 1);
+}
+
+TEST(Map, EraseWithMemberIndex)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SettingManager::SaveMethod::SaveManually;
+    sm->setMemberIndexThreshold(4);
+
+    Setting<std::map<std::string, int>> map("/members/index", sm);
+    map = std::map<std::string, int>{};
+
+    for (int i = 0; i < 50; ++i) {
+        EXPECT_TRUE(map.insertOrAssign("key" + std::to_string(i), i));
+    }
+    for (int i = 0; i < 50; i += 3) {
+        EXPECT_TRUE(map.erase("key" + std::to_string(i)));
+    }
+
+    for (int i = 0; i < 50; ++i) {
+        const auto *value = sm->get("/members/index/key" + std::to_string(i));
+        if (i % 3 == 0) {
+            EXPECT_EQ(value, nullptr);
+        } else {
+            ASSERT_NE(value, nullptr);
+            EXPECT_EQ(value->GetInt(), i);
+        }
+    }
+
+    // Reading the map from the document again gives the same result
+    Setting<std::map<std::string, int>> other("/members/index", sm);
+    EXPECT_EQ(other.getValue(), map.getValue());
+    EXPECT_EQ(map.getValue().size(), 33);
+}
@@ -0,0 +1,97 @@
+#include <gtest/gtest.h>
+
+#include <pajlada/settings.hpp>
+#include <pajlada/settings/detail/memberindex.hpp>
+#include <string>
+
+using namespace pajlada::Settings;
+using SaveMethod = SettingManager::SaveMethod;
+
+namespace {
+
+void
+addMembers(rapidjson::Document &document, int from, int to)
+{
+    for (int i = from; i < to; ++i) {
+        auto name = "key" + std::to_string(i);
+        document.AddMember(
+            rapidjson::Value(name.c_str(), document.GetAllocator()).Move(),
+            rapidjson::Value(i).Move(), document.GetAllocator());
+    }
+}
+
+}  // namespace
+
+TEST(MemberIndex, Find)
+{
+    rapidjson::Document document;
+    document.SetObject();
+    addMembers(document, 0, 10);
+
+    detail::MemberIndex index;
+    index.setThreshold(4);
+
+    for (int i = 0; i < 10; ++i) {
+        auto *value = index.find(document, "key" + std::to_string(i));
+        ASSERT_NE(value, nullptr);
+        EXPECT_EQ(value->GetInt(), i);
+    }
+    EXPECT_EQ(index.find(document, "missing"), nullptr);
+    EXPECT_EQ(index.size(), 1);
+
+    // Appended members are added to the table
+    addMembers(document, 10, 100);
+    ASSERT_NE(index.find(document, "key99"), nullptr);
+    EXPECT_EQ(index.find(document, "key99")->GetInt(), 99);
+
+    // Removing moves the last member, the table is rebuilt
+    document.RemoveMember("key3");
+    EXPECT_EQ(index.find(document, "key3"), nullptr);
+    ASSERT_NE(index.find(document, "key99"), nullptr);
+    EXPECT_EQ(index.find(document, "key99")->GetInt(), 99);
+
+    index.clear();
+    EXPECT_EQ(index.size(), 0);
+}
+
+TEST(MemberIndex, SmallObjectsAreNotIndexed)
+{
+    rapidjson::Document document;
+    document.SetObject();
+    addMembers(document, 0, 3);
+
+    detail::MemberIndex index;
+    EXPECT_EQ(index.find(document, "key1")->GetInt(), 1);
+    EXPECT_EQ(index.size(), 0);
+
+    index.setThreshold(4);
+    EXPECT_EQ(index.find(document, "key1")->GetInt(), 1);
+    EXPECT_EQ(index.size(), 0);
+}
+
+TEST(MemberIndex, SettingManager)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+    sm->setMemberIndexThreshold(8);
+
+    for (int i = 0; i < 100; ++i) {
+        auto path = "/channels/channel" + std::to_string(i) + "/id";
+        EXPECT_TRUE(sm->set(path, rapidjson::Value(i)));
+    }
+
+    Setting<int> channel50("/channels/channel50/id", sm);
+    EXPECT_EQ(channel50.getValue(), 50);
+
+    channel50 = 500;
+    EXPECT_EQ(sm->get("/channels/channel50/id")->GetInt(), 500);
+
+    EXPECT_TRUE(sm->removeSetting("/channels/channel99"));
+    EXPECT_EQ(sm->get("/channels/channel99/id"), nullptr);
+    EXPECT_EQ(sm->get("/channels/channel98/id")->GetInt(), 98);
+
+    Setting<int> channel200("/channels/channel200/id", sm);
+    channel200 = 200;
+    EXPECT_EQ(sm->get("/channels/channel200/id")->GetInt(), 200);
+    EXPECT_EQ(sm->document["channels"].MemberCount(), 100);
+}
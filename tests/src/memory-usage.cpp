@@ -0,0 +1,62 @@
+#include <gtest/gtest.h>
+
+#include <pajlada/settings.hpp>
+#include <string>
+
+using namespace pajlada::Settings;
+using SaveMethod = SettingManager::SaveMethod;
+using LoadError = SettingManager::LoadError;
+
+TEST(MemoryUsage, Registry)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    auto empty = sm->memoryUsage();
+    EXPECT_EQ(empty.settingCount, 0);
+    EXPECT_EQ(empty.listenerCount, 0);
+    EXPECT_TRUE(empty.topLevel.empty());
+
+    Setting<int> a("/memory/a", sm);
+    Setting<int> a2("/memory/a", sm);
+    Setting<int> b("/memory/b", sm);
+
+    a.connect([](int) {}, false);
+    a2.connect([](int) {}, false);
+    b.connect([] {}, false);
+
+    auto usage = sm->memoryUsage();
+    EXPECT_EQ(usage.settingCount, 2);
+    EXPECT_GE(usage.settingPathBytes, 2 * std::string("/memory/a").size());
+    EXPECT_EQ(usage.listenerCount, 3);
+}
+
+TEST(MemoryUsage, Document)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    Setting<std::string> small("/small", sm);
+    Setting<std::string> large("/large/value", sm);
+
+    small = "x";
+    large = std::string(1000, 'x');
+
+    auto usage = sm->memoryUsage();
+    EXPECT_GT(usage.allocatorUsed, 0);
+    EXPECT_GE(usage.allocatorCapacity, usage.allocatorUsed);
+    EXPECT_GT(usage.liveBytes, 1000);
+    EXPECT_LE(usage.liveBytes, usage.allocatorUsed);
+
+    ASSERT_EQ(usage.topLevel.size(), 2);
+    EXPECT_EQ(usage.topLevel[0].key, "small");
+    EXPECT_EQ(usage.topLevel[1].key, "large");
+    EXPECT_GT(usage.topLevel[1].bytes, 1000);
+    EXPECT_LT(usage.topLevel[0].bytes, usage.topLevel[1].bytes);
+
+    // Overwriting leaves the old string behind in the pool
+    large = std::string(1000, 'y');
+    auto after = sm->memoryUsage();
+    EXPECT_GT(after.allocatorUsed, usage.allocatorUsed);
+    EXPECT_LT(after.liveRatio, usage.liveRatio);
+}
@@ -31,6 +31,19 @@ TEST(Misc, StdAny)
     auto v2 = test2->getValue();
 }
 
+TEST(Misc, SetInvalidPath)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    ASSERT_TRUE(sm->set("/valid", rapidjson::Value(1)));
+
+    // A path without the leading / is not a valid JSON pointer
+    EXPECT_FALSE(sm->set("invalid", rapidjson::Value(2)));
+    EXPECT_TRUE(sm->document.IsObject());
+    EXPECT_EQ(sm->get("/valid")->GetInt(), 1);
+}
+
 TEST(Misc, Array)
 {
     auto sm = std::make_shared<SettingManager>();
@@ -9,6 +9,44 @@ using SaveResult = SettingManager::SaveResult;
 using SaveMethod = SettingManager::SaveMethod;
 using LoadError = SettingManager::LoadError;
 
+namespace {
+
+struct CountedStruct {
+    int a;
+
+    bool operator==(const CountedStruct &other) const = default;
+};
+
+int countedSerializations = 0;
+
+}  // namespace
+
+namespace pajlada {
+
+template <>
+struct Serialize<CountedStruct> {
+    static rapidjson::Value
+    get(const CountedStruct &value, rapidjson::Document::AllocatorType &a)
+    {
+        ++countedSerializations;
+
+        return pajlada::Serialize<int>::get(value.a, a);
+    }
+};
+
+template <>
+struct Deserialize<CountedStruct> {
+    static CountedStruct
+    get(const rapidjson::Value &value, bool *error = nullptr)
+    {
+        return {
+            .a = pajlada::Deserialize<int>::get(value, error),
+        };
+    }
+};
+
+}  // namespace pajlada
+
 TEST(OptionCompareBeforeSet, Off)
 {
     auto sm = std::make_shared<SettingManager>();
@@ -281,3 +319,55 @@ TEST(OptionCompareBeforeSet, VectorComparableType)
     EXPECT_EQ(count, 1);
     EXPECT_EQ(currentValue.size(), 1);
 }
+
+TEST(OptionCompareBeforeSet, TypedCompareSkipsSerialization)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    int count = 0;
+    Setting<CountedStruct> a("/simple_signal/a",
+                             SettingOption::CompareBeforeSet, sm);
+    a.connect(
+        [&count](const auto &, auto) {
+            ++count;
+        },
+        false);
+
+    countedSerializations = 0;
+
+    a = CountedStruct{.a = 1};
+    EXPECT_EQ(count, 1);
+    EXPECT_EQ(countedSerializations, 1);
+
+    // Equal to the cached value
+    a = CountedStruct{.a = 1};
+    EXPECT_EQ(count, 1);
+    EXPECT_EQ(countedSerializations, 1);
+
+    // Changed through the document, the cached value is refreshed first
+    sm->set("/simple_signal/a", rapidjson::Value(2));
+    EXPECT_EQ(count, 2);
+
+    a = CountedStruct{.a = 2};
+    EXPECT_EQ(count, 2);
+    EXPECT_EQ(countedSerializations, 1);
+
+    a = CountedStruct{.a = 3};
+    EXPECT_EQ(count, 3);
+    EXPECT_EQ(countedSerializations, 2);
+    EXPECT_EQ(a.getValue().a, 3);
+}
+
+TEST(OptionCompareBeforeSet, TypedComparable)
+{
+    static_assert(pajlada::IsTypedComparable<int>::value);
+    static_assert(
+        pajlada::IsTypedComparable<std::vector<ComparableStruct>>::value);
+    static_assert(!pajlada::IsTypedComparable<NonComparableStruct>::value);
+    static_assert(
+        !pajlada::IsTypedComparable<std::vector<NonComparableStruct>>::value);
+    static_assert(!pajlada::IsTypedComparable<std::any>::value);
+    static_assert(
+        !pajlada::IsTypedComparable<std::map<std::string, std::any>>::value);
+}
@@ -0,0 +1,137 @@
+#include <gtest/gtest.h>
+
+#include <pajlada/settings.hpp>
+#include <pajlada/settings/pathtable.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace pajlada::Settings;
+using SaveMethod = SettingManager::SaveMethod;
+
+TEST(PathTable, Intern)
+{
+    auto a = PathID::intern("/path-table/intern/a");
+    auto a2 = PathID::intern(std::string("/path-table/intern/a"));
+    auto b = PathID::intern("/path-table/intern/b");
+
+    EXPECT_EQ(a, a2);
+    EXPECT_NE(a, b);
+    EXPECT_EQ(a.str(), "/path-table/intern/a");
+    EXPECT_EQ(b.view(), "/path-table/intern/b");
+
+    EXPECT_EQ(PathTable::instance().find("/path-table/intern/a"), a);
+    EXPECT_TRUE(PathTable::instance().find("/path-table/intern/c").empty());
+
+    PathID empty;
+    EXPECT_TRUE(empty.empty());
+    EXPECT_EQ(empty.str(), "");
+    EXPECT_EQ(PathID::intern(""), empty);
+}
+
+TEST(PathTable, ManyPaths)
+{
+    // Spans several chunks of the table
+    std::vector<PathID> ids;
+    for (int i = 0; i < 5000; ++i) {
+        ids.push_back(
+            PathID::intern("/path-table/many/" + std::to_string(i)));
+    }
+
+    for (int i = 0; i < 5000; ++i) {
+        EXPECT_EQ(ids[i].str(), "/path-table/many/" + std::to_string(i));
+    }
+}
+
+TEST(PathTable, Concurrent)
+{
+    constexpr int numThreads = 4;
+    constexpr int numPaths = 2000;
+
+    std::vector<std::vector<PathID>> results(numThreads);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < numThreads; ++t) {
+        threads.emplace_back([t, &results] {
+            for (int i = 0; i < numPaths; ++i) {
+                results[t].push_back(PathID::intern(
+                    "/path-table/concurrent/" + std::to_string(i)));
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    for (int t = 1; t < numThreads; ++t) {
+        EXPECT_EQ(results[t], results[0]);
+    }
+}
+
+TEST(PathTable, Setting)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    Setting<int> a("/path-table/setting/a", sm);
+    Setting<int> a2("/path-table/setting/a", sm);
+
+    EXPECT_EQ(a.getPathID(), a2.getPathID());
+    EXPECT_EQ(a.getPathID(), PathID::intern("/path-table/setting/a"));
+    EXPECT_EQ(a.getPath(), "/path-table/setting/a");
+
+    PathID changedPath;
+    a.connect(
+        [&](const int &, const SignalArgs &args) {
+            changedPath = args.pathID;
+        },
+        false);
+
+    a2 = 5;
+    EXPECT_EQ(changedPath, a.getPathID());
+}
+
+TEST(PathTable, Release)
+{
+    auto &table = PathTable::instance();
+    auto before = table.size();
+
+    auto a = PathID::intern("/path-table/release/a");
+    auto a2 = PathID::intern("/path-table/release/a");
+    EXPECT_EQ(table.size(), before + 1);
+
+    a2.release();
+    EXPECT_EQ(table.find("/path-table/release/a"), a);
+
+    a.release();
+    EXPECT_TRUE(table.find("/path-table/release/a").empty());
+    EXPECT_EQ(table.size(), before);
+
+    // The ID is reused by the next path
+    auto b = PathID::intern("/path-table/release/b");
+    EXPECT_EQ(b, a);
+    EXPECT_EQ(b.str(), "/path-table/release/b");
+    b.release();
+}
+
+TEST(PathTable, ReleasedWithSetting)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    {
+        Setting<int> a("/path-table/released/a", sm);
+        a = 1;
+
+        Setting<int> copy(a);
+    }
+
+    // The registry entry still holds the path
+    EXPECT_FALSE(
+        PathTable::instance().find("/path-table/released/a").empty());
+
+    EXPECT_EQ(sm->compactRegistry(), 1);
+    EXPECT_TRUE(PathTable::instance().find("/path-table/released/a").empty());
+
+    // The value is still in the document
+    EXPECT_EQ(Setting<int>::get("/path-table/released/a", sm), 1);
+}
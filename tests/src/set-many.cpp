@@ -0,0 +1,214 @@
+#include <gtest/gtest.h>
+#include <rapidjson/pointer.h>
+
+#include <pajlada/settings.hpp>
+#include <pajlada/settings/coalescingsettinglistener.hpp>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace pajlada::Settings;
+using namespace pajlada;
+using SaveMethod = SettingManager::SaveMethod;
+
+TEST(SetMany, GetMany)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    Setting<int> a("/many/get/a/x", 1, sm);
+    Setting<int> b("/many/get/a/y", 2, sm);
+    Setting<std::string> c("/many/get/b", sm);
+    a = 10;
+    b = 20;
+    c = "c";
+
+    auto values = sm->getMany(std::vector<std::string>{
+        "/many/get/a/x",
+        "/many/get/a/y",
+        "/many/get/a/z",
+        "/many/get/b",
+        "/many/get/b/nested",
+        "many/get/b",
+        "",
+    });
+    ASSERT_EQ(values.size(), 7);
+
+    ASSERT_NE(values[0], nullptr);
+    EXPECT_EQ(values[0]->GetInt(), 10);
+    ASSERT_NE(values[1], nullptr);
+    EXPECT_EQ(values[1]->GetInt(), 20);
+    EXPECT_EQ(values[2], nullptr);
+    ASSERT_NE(values[3], nullptr);
+    EXPECT_STREQ(values[3]->GetString(), "c");
+    EXPECT_EQ(values[4], nullptr);
+    EXPECT_EQ(values[5], nullptr);
+    EXPECT_EQ(values[6], &sm->document);
+
+    auto byID = sm->getMany(std::vector<PathID>{
+        a.getPathID(),
+        c.getPathID(),
+    });
+    ASSERT_EQ(byID.size(), 2);
+    EXPECT_EQ(byID[0], values[0]);
+    EXPECT_EQ(byID[1], values[3]);
+}
+
+TEST(SetMany, EscapedTokens)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    std::vector<std::pair<std::string, rapidjson::Value>> values;
+    values.emplace_back("/many/escape/a~1b", rapidjson::Value(1));
+    values.emplace_back("/many/escape/a~0b", rapidjson::Value(2));
+    values.emplace_back("/many/escape/bad~2", rapidjson::Value(3));
+    EXPECT_EQ(sm->setMany(values), 2);
+
+    EXPECT_EQ(
+        rapidjson::Pointer("/many/escape/a~1b").Get(sm->document)->GetInt(), 1);
+    EXPECT_EQ(
+        rapidjson::Pointer("/many/escape/a~0b").Get(sm->document)->GetInt(), 2);
+    EXPECT_EQ(sm->document["many"]["escape"].MemberCount(), 2);
+}
+
+TEST(SetMany, CreatesPathsAndNotifies)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    Setting<int> a("/many/set/a", sm);
+    Setting<std::vector<int>> b("/many/set/b", sm);
+
+    std::vector<int> aValues;
+    a.connect(
+        [&](const int &newValue) {
+            // Every value is written before the first listener runs
+            EXPECT_EQ(sm->get("/many/set/c/1")->GetInt(), 3);
+            aValues.push_back(newValue);
+        },
+        false);
+
+    int bCount = 0;
+    b.connect(
+        [&](const std::vector<int> &) {
+            ++bCount;
+        },
+        false);
+
+    std::vector<std::pair<std::string, rapidjson::Value>> values;
+    values.emplace_back("/many/set/a", rapidjson::Value(5));
+    values.emplace_back("/many/set/b/0", rapidjson::Value(1));
+    values.emplace_back("/many/set/c/1", rapidjson::Value(3));
+    EXPECT_EQ(sm->setMany(values), 3);
+
+    EXPECT_EQ(aValues, std::vector<int>{5});
+    EXPECT_EQ(a.getValue(), 5);
+
+    // Only listeners of the exact path are notified, like with set
+    EXPECT_EQ(bCount, 0);
+    EXPECT_EQ(b.getValue(), std::vector<int>{1});
+
+    const auto *c = sm->get("/many/set/c");
+    ASSERT_NE(c, nullptr);
+    ASSERT_TRUE(c->IsArray());
+    ASSERT_EQ(c->Size(), 2);
+    EXPECT_TRUE((*c)[0].IsNull());
+    EXPECT_EQ((*c)[1].GetInt(), 3);
+}
+
+TEST(SetMany, CompareBeforeSet)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    Setting<int> a("/many/compare/a", sm);
+    Setting<int> b("/many/compare/b", sm);
+    a = 1;
+    b = 2;
+
+    int count = 0;
+    a.connect(
+        [&](const int &) {
+            ++count;
+        },
+        false);
+    b.connect(
+        [&](const int &) {
+            ++count;
+        },
+        false);
+
+    std::vector<std::pair<PathID, rapidjson::Value>> values;
+    values.emplace_back(a.getPathID(), rapidjson::Value(1));
+    values.emplace_back(b.getPathID(), rapidjson::Value(3));
+
+    SignalArgs args;
+    args.compareBeforeSet = true;
+    EXPECT_EQ(sm->setMany(values, std::move(args)), 1);
+    EXPECT_EQ(count, 1);
+    EXPECT_EQ(b.getValue(), 3);
+}
+
+TEST(SetMany, FlatStorage)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    Setting<int> a("/many/flat/a", SettingOption::FlatStorage, sm);
+    a = 1;
+    EXPECT_EQ(a.getValue(), 1);
+
+    std::vector<std::pair<std::string, rapidjson::Value>> values;
+    values.emplace_back("/many/flat/a", rapidjson::Value(2));
+    EXPECT_EQ(sm->setMany(values), 1);
+    EXPECT_EQ(a.getValue(), 2);
+}
+
+TEST(SetMany, CoalescingListenerGetsOneBatch)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    Setting<int> a("/many/coalescing/a", sm);
+    Setting<int> b("/many/coalescing/b", sm);
+    Setting<int> c("/many/coalescing/c", sm);
+
+    std::vector<std::vector<std::string>> batches;
+    CoalescingSettingListener listener(
+        [&](const std::vector<std::string> &paths) {
+            batches.push_back(paths);
+        });
+    listener.addSetting(a);
+    listener.addSetting(b);
+    listener.addSetting(c);
+
+    std::vector<std::pair<std::string, rapidjson::Value>> values;
+    values.emplace_back("/many/coalescing/a", rapidjson::Value(1));
+    values.emplace_back("/many/coalescing/b", rapidjson::Value(2));
+    values.emplace_back("/many/coalescing/c", rapidjson::Value(3));
+    EXPECT_EQ(sm->setMany(values), 3);
+
+    ASSERT_EQ(batches.size(), 1);
+    EXPECT_EQ(batches[0].size(), 3);
+
+    // Single writes are still delivered right away
+    a = 5;
+    ASSERT_EQ(batches.size(), 2);
+    EXPECT_EQ(batches[1], std::vector<std::string>{a.getPath()});
+}
+
+TEST(SetMany, Frozen)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    Setting<int> a("/many/frozen/a", sm);
+    a = 1;
+    sm->freeze();
+
+    std::vector<std::pair<std::string, rapidjson::Value>> values;
+    values.emplace_back("/many/frozen/a", rapidjson::Value(2));
+    EXPECT_EQ(sm->setMany(values), 0);
+    EXPECT_EQ(a.getValue(), 1);
+}
@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+
+#include <pajlada/settings.hpp>
+
+#include "common.hpp"
+
+using namespace pajlada::Settings;
+using SaveResult = SettingManager::SaveResult;
+using SaveMethod = SettingManager::SaveMethod;
+using LoadError = SettingManager::LoadError;
+
+TEST(Stats, Counters)
+{
+#ifndef PAJLADA_SETTINGS_STATS
+    GTEST_SKIP() << "Built without PAJLADA_SETTINGS_STATS";
+#endif
+
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+    sm->setBackupEnabled(false);
+
+    auto initial = sm->stats();
+    EXPECT_EQ(initial.getCalls, 0);
+    EXPECT_EQ(initial.setCalls, 0);
+    EXPECT_EQ(initial.notificationsFired, 0);
+
+    int listenerCalls = 0;
+    Setting<int> a("/stats/a", sm);
+    a.connect(
+        [&](int) {
+            ++listenerCalls;
+        },
+        false);
+
+    a = 5;
+    EXPECT_EQ(a.getValue(), 5);
+    EXPECT_EQ(a.getValue(), 5);
+
+    auto s = sm->stats();
+    EXPECT_EQ(s.setCalls, 1);
+    EXPECT_EQ(s.getCalls, 2);
+    EXPECT_GT(s.pointerResolutions, 0);
+    EXPECT_EQ(s.notificationsFired, 1);
+    EXPECT_EQ(s.listenerTime.count, 1);
+    EXPECT_EQ(listenerCalls, 1);
+
+    // Writes that check the current value first aren't reads
+    a.update([](int &value) {
+        ++value;
+    });
+    EXPECT_EQ(sm->stats().getCalls, 2);
+}
+
+TEST(Stats, Save)
+{
+#ifndef PAJLADA_SETTINGS_STATS
+    GTEST_SKIP() << "Built without PAJLADA_SETTINGS_STATS";
+#endif
+
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::OnlySaveIfChanged;
+    sm->setBackupEnabled(false);
+
+    Setting<int>::set("/stats/save", 10, sm);
+
+    EXPECT_EQ(SaveResult::Success, sm->saveAs("files/out.stats.save.json"));
+    EXPECT_EQ(SaveResult::Skipped, sm->saveAs("files/out.stats.save.json"));
+
+    auto s = sm->stats();
+    EXPECT_EQ(s.savesAttempted, 2);
+    EXPECT_EQ(s.savesSkipped, 1);
+    EXPECT_EQ(s.savesFailed, 0);
+    EXPECT_GT(s.bytesWritten, 0);
+    EXPECT_EQ(s.saveDuration.count, 1);
+    // Backups are disabled
+    EXPECT_EQ(s.backupRotationTime.count, 0);
+
+    sm->setBackupEnabled(true);
+    Setting<int>::set("/stats/save", 11, sm);
+    EXPECT_EQ(SaveResult::Success, sm->saveAs("files/out.stats.save.json"));
+    EXPECT_EQ(sm->stats().backupRotationTime.count, 1);
+}
+
+TEST(Stats, Load)
+{
+#ifndef PAJLADA_SETTINGS_STATS
+    GTEST_SKIP() << "Built without PAJLADA_SETTINGS_STATS";
+#endif
+
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    Setting<int> a("/a", sm);
+
+    ASSERT_EQ(sm->loadFrom("files/in.normal.json"), LoadError::NoError);
+    ASSERT_EQ(WaitForLoad(*sm, sm->loadAsync("files/in.normal.json")),
+              LoadError::NoError);
+
+    auto s = sm->stats();
+    EXPECT_EQ(s.loadDuration.count, 2);
+    // One notification for /a per load
+    EXPECT_EQ(s.notificationsFired, 2);
+
+    std::uint64_t bucketTotal = 0;
+    for (auto n : s.loadDuration.buckets) {
+        bucketTotal += n;
+    }
+    EXPECT_EQ(bucketTotal, s.loadDuration.count);
+    EXPECT_GE(s.loadDuration.total, s.loadDuration.max);
+}
@@ -0,0 +1,162 @@
+#include <gtest/gtest.h>
+#include <rapidjson/document.h>
+
+#include <algorithm>
+#include <fstream>
+#include <mutex>
+#include <pajlada/settings.hpp>
+#include <pajlada/settings/trace.hpp>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace pajlada::Settings;
+using SaveResult = SettingManager::SaveResult;
+using SaveMethod = SettingManager::SaveMethod;
+using LoadError = SettingManager::LoadError;
+
+namespace {
+
+class MemorySink : public Trace::Sink
+{
+public:
+    void
+    write(const Trace::Event &event) override
+    {
+        std::lock_guard lock(this->mutex);
+        this->events.push_back({
+            .name = std::string(event.name),
+            .detail = event.detail,
+            .count = event.count,
+        });
+    }
+
+    struct Entry {
+        std::string name;
+        std::string detail;
+        std::int64_t count;
+    };
+
+    const Entry *
+    find(const std::string &name) const
+    {
+        auto it = std::find_if(this->events.begin(), this->events.end(),
+                               [&](const auto &e) {
+                                   return e.name == name;
+                               });
+        if (it == this->events.end()) {
+            return nullptr;
+        }
+        return &*it;
+    }
+
+    std::mutex mutex;
+    std::vector<Entry> events;
+};
+
+/// Removes the global sink when the test ends
+struct SinkGuard {
+    explicit SinkGuard(std::shared_ptr<Trace::Sink> sink)
+    {
+        Trace::setSink(std::move(sink));
+    }
+
+    ~SinkGuard()
+    {
+        Trace::setSink(nullptr);
+    }
+};
+
+}  // namespace
+
+TEST(Trace, Disabled)
+{
+    EXPECT_FALSE(Trace::isEnabled());
+
+    Trace::Span span("test");
+    EXPECT_FALSE(span.active());
+}
+
+TEST(Trace, NotifyUpdate)
+{
+    auto sink = std::make_shared<MemorySink>();
+    SinkGuard guard(sink);
+    EXPECT_TRUE(Trace::isEnabled());
+
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    Setting<int> a("/trace/notify/a", sm);
+    a.connect([](int) {}, false);
+    a.connect([](int) {}, false);
+
+    a = 5;
+
+    const auto *e = sink->find("notifyUpdate");
+    ASSERT_NE(e, nullptr);
+    EXPECT_EQ(e->detail, "/trace/notify/a");
+    EXPECT_EQ(e->count, 2);
+}
+
+TEST(Trace, LoadSave)
+{
+    auto sink = std::make_shared<MemorySink>();
+    SinkGuard guard(sink);
+
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    Setting<int> a("/a", sm);
+
+    ASSERT_EQ(sm->loadFrom("files/in.normal.json"), LoadError::NoError);
+
+    for (const auto *name : {"readFrom", "read", "parse", "notifyLoadedValues",
+                             "notifyUpdate"}) {
+        EXPECT_NE(sink->find(name), nullptr) << name;
+    }
+    EXPECT_EQ(sink->find("readFrom")->detail, "files/in.normal.json");
+
+    sm->setBackupEnabled(false);
+    ASSERT_EQ(sm->saveAs("files/out.trace.json"), SaveResult::Success);
+
+    for (const auto *name : {"saveAs", "serialize", "write", "renameFile"}) {
+        EXPECT_NE(sink->find(name), nullptr) << name;
+    }
+}
+
+TEST(Trace, ChromeTraceSink)
+{
+    {
+        auto sink = std::make_shared<Trace::ChromeTraceSink>(
+            "files/out.trace.chrome.json");
+        ASSERT_TRUE(sink->isOpen());
+        SinkGuard guard(sink);
+
+        {
+            Trace::Span span("outer");
+            span.setDetail("quote \" in detail");
+            span.setCount(3);
+        }
+        Trace::instant("marker", "");
+    }
+
+    std::ifstream fh("files/out.trace.chrome.json");
+    std::stringstream ss;
+    ss << fh.rdbuf();
+
+    rapidjson::Document d;
+    d.Parse(ss.str());
+    ASSERT_FALSE(d.HasParseError());
+    ASSERT_TRUE(d.IsArray());
+    ASSERT_EQ(d.Size(), 2);
+
+    const auto &span = d[0];
+    EXPECT_STREQ(span["name"].GetString(), "outer");
+    EXPECT_STREQ(span["ph"].GetString(), "X");
+    EXPECT_TRUE(span["dur"].IsNumber());
+    EXPECT_STREQ(span["args"]["detail"].GetString(), "quote \" in detail");
+    EXPECT_EQ(span["args"]["count"].GetInt64(), 3);
+
+    EXPECT_STREQ(d[1]["name"].GetString(), "marker");
+    EXPECT_STREQ(d[1]["ph"].GetString(), "i");
+}
@@ -0,0 +1,291 @@
+#include <gtest/gtest.h>
+
+#include <limits>
+#include <pajlada/settings.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace pajlada::Settings;
+using SaveMethod = SettingManager::SaveMethod;
+
+TEST(Update, InPlace)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    Setting<std::vector<std::string>> list(
+        "/update/list", std::vector<std::string>{"a"}, sm);
+
+    int count = 0;
+    list.connect(
+        [&](const std::vector<std::string> &) {
+            ++count;
+        },
+        false);
+
+    // Starts from the default value
+    EXPECT_TRUE(list.update([](auto &value) {
+        value.push_back("b");
+        value.push_back("c");
+    }));
+    EXPECT_EQ(count, 1);
+    EXPECT_EQ(list.getValue(), (std::vector<std::string>{"a", "b", "c"}));
+
+    EXPECT_TRUE(list.update([](auto &value) {
+        value.erase(value.begin());
+    }));
+    EXPECT_EQ(count, 2);
+    EXPECT_EQ(list.getValue(), (std::vector<std::string>{"b", "c"}));
+
+    Setting<std::vector<std::string>> other("/update/list", sm);
+    EXPECT_EQ(other.getValue(), (std::vector<std::string>{"b", "c"}));
+}
+
+TEST(Update, CompareBeforeSet)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    Setting<int> a("/update/compare", SettingOption::CompareBeforeSet, sm);
+    a = 5;
+
+    int count = 0;
+    a.connect(
+        [&](const int &) {
+            ++count;
+        },
+        false);
+
+    EXPECT_FALSE(a.update([](int &) {}));
+    EXPECT_EQ(count, 0);
+    EXPECT_EQ(a.getValue(), 5);
+
+    EXPECT_TRUE(a.update([](int &value) {
+        ++value;
+    }));
+    EXPECT_EQ(count, 1);
+    EXPECT_EQ(a.getValue(), 6);
+}
+
+TEST(Update, ConcurrentUpdatesAreNotLost)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    Setting<std::vector<int>> a("/update/threads", sm);
+    Setting<std::vector<int>> b("/update/threads", sm);
+
+    auto run = [](Setting<std::vector<int>> &setting, int tag) {
+        for (int i = 0; i < 500; ++i) {
+            setting.update([tag](std::vector<int> &value) {
+                value.push_back(tag);
+            });
+        }
+    };
+
+    std::thread first(run, std::ref(a), 1);
+    std::thread second(run, std::ref(b), 2);
+    first.join();
+    second.join();
+
+    EXPECT_EQ(a.getValue().size(), 1000);
+    EXPECT_EQ(b.getValue().size(), 1000);
+}
+
+TEST(Update, ConcurrentPushBackAndUpdate)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    Setting<std::vector<int>> a("/update/push-back-threads", sm);
+    Setting<std::vector<int>> b("/update/push-back-threads", sm);
+    a = std::vector<int>{};
+
+    std::thread first([&a] {
+        for (int i = 0; i < 500; ++i) {
+            a.push_back(1);
+        }
+    });
+    std::thread second([&b] {
+        for (int i = 0; i < 500; ++i) {
+            b.update([](std::vector<int> &value) {
+                value.push_back(2);
+            });
+        }
+    });
+    first.join();
+    second.join();
+
+    EXPECT_EQ(a.getValue().size(), 1000);
+    EXPECT_EQ(b.getValue().size(), 1000);
+    EXPECT_EQ(SettingManager::arraySize("/update/push-back-threads", sm),
+              1000);
+}
+
+TEST(Update, ListenerChangesItsSetting)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    Setting<std::vector<int>> list("/update/listener", sm);
+    list = std::vector<int>{0};
+
+    list.connect(
+        [&list](const std::vector<int> &value, const SignalArgs &) {
+            // Runs without the update lock, so this doesn't deadlock
+            if (value.size() < 3) {
+                list.push_back(static_cast<int>(value.size()));
+            } else if (value.size() == 3) {
+                list.update([](std::vector<int> &v) {
+                    v.push_back(3);
+                });
+            }
+        },
+        false);
+
+    list.push_back(1);
+
+    EXPECT_EQ(list.getValue(), (std::vector<int>{0, 1, 2, 3}));
+}
+
+TEST(Update, CompareAndSet)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    Setting<int> a("/update/cas", 1, sm);
+
+    // Compares with the default value while unset
+    EXPECT_FALSE(a.compareAndSet(2, 3));
+    EXPECT_FALSE(a.hasValueBeenSet());
+
+    EXPECT_TRUE(a.compareAndSet(1, 3));
+    EXPECT_EQ(a.getValue(), 3);
+
+    Setting<int> b("/update/cas", sm);
+    EXPECT_FALSE(b.compareAndSet(1, 4));
+    EXPECT_TRUE(b.compareAndSet(3, 4));
+    EXPECT_EQ(a.getValue(), 4);
+}
+
+TEST(Update, SetIfVersion)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    EXPECT_EQ(sm->getVersion("/update/version"), -1);
+    EXPECT_FALSE(sm->setIfVersion("/update/version", rapidjson::Value(1), 0));
+
+    Setting<int> a("/update/version", sm);
+    a = 1;
+
+    auto version = sm->getVersion("/update/version");
+    EXPECT_NE(version, -1);
+
+    EXPECT_TRUE(
+        sm->setIfVersion("/update/version", rapidjson::Value(2), version));
+    EXPECT_EQ(a.getValue(), 2);
+
+    // The version has moved on
+    EXPECT_FALSE(
+        sm->setIfVersion("/update/version", rapidjson::Value(3), version));
+    EXPECT_EQ(a.getValue(), 2);
+
+    EXPECT_TRUE(sm->setIfVersion("/update/version", rapidjson::Value(3),
+                                 sm->getVersion("/update/version")));
+    EXPECT_EQ(a.getValue(), 3);
+}
+
+TEST(Update, FetchAdd)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    Setting<int> a("/update/add/a", 10, sm);
+
+    int count = 0;
+    a.connect(
+        [&](const int &) {
+            ++count;
+        },
+        false);
+
+    EXPECT_EQ(a.fetchAdd(1), 10);
+    EXPECT_EQ(a.fetchAdd(-3), 11);
+    EXPECT_EQ(a.getValue(), 8);
+    EXPECT_EQ(count, 2);
+    EXPECT_EQ(sm->get("/update/add/a")->GetInt(), 8);
+
+    Setting<double> b("/update/add/b", SettingOption::FlatStorage, sm);
+    EXPECT_EQ(b.fetchAdd(0.5), 0.0);
+    EXPECT_EQ(b.fetchAdd(0.5), 0.5);
+    EXPECT_EQ(b.getValue(), 1.0);
+    EXPECT_EQ(sm->flushFlatStorage(), 1);
+    EXPECT_EQ(sm->get("/update/add/b")->GetDouble(), 1.0);
+}
+
+TEST(Update, FetchAddWraps)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    Setting<int> a("/update/add-wraps/a", std::numeric_limits<int>::max(),
+                   sm);
+    EXPECT_EQ(a.fetchAdd(1), std::numeric_limits<int>::max());
+    EXPECT_EQ(a.getValue(), std::numeric_limits<int>::min());
+
+    Setting<int> b("/update/add-wraps/b", std::numeric_limits<int>::min(),
+                   SettingOption::FlatStorage, sm);
+    EXPECT_EQ(b.fetchAdd(-1), std::numeric_limits<int>::min());
+    EXPECT_EQ(b.getValue(), std::numeric_limits<int>::max());
+}
+
+TEST(Update, FetchAddRemoved)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    Setting<int> a("/update/add-removed/a", 10, sm);
+    EXPECT_EQ(a.fetchAdd(5), 10);
+    EXPECT_EQ(a.getValue(), 15);
+
+    ASSERT_TRUE(sm->removeSetting("/update/add-removed/a"));
+
+    // Nothing is changed, the cached value is returned
+    EXPECT_EQ(a.fetchAdd(1), 15);
+
+    // Never set, so the default value is returned
+    Setting<int> b("/update/add-removed/b", 7, sm);
+    sm->removeSetting("/update/add-removed/b");
+    EXPECT_FALSE(b.isValid());
+    EXPECT_EQ(b.fetchAdd(1), 7);
+}
+
+TEST(Update, ConcurrentFetchAdd)
+{
+    auto sm = std::make_shared<SettingManager>();
+    sm->saveMethod = SaveMethod::SaveManually;
+
+    for (auto option : {SettingOption::Default, SettingOption::FlatStorage}) {
+        const std::string path =
+            "/update/add-threads/" +
+            std::to_string(static_cast<std::uint32_t>(option));
+
+        Setting<std::uint64_t> a(path, option, sm);
+        Setting<std::uint64_t> b(path, option, sm);
+
+        auto run = [](Setting<std::uint64_t> &setting) {
+            for (int i = 0; i < 500; ++i) {
+                setting.fetchAdd(1);
+            }
+        };
+
+        std::thread first(run, std::ref(a));
+        std::thread second(run, std::ref(b));
+        first.join();
+        second.join();
+
+        EXPECT_EQ(a.getValue(), 1000);
+    }
+}